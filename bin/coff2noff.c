@@ -22,6 +22,7 @@
 #include "coff_reader.h"
 #include "coff_section.h"
 #include "noff.h"
+#include "extern/syms.h"
 #include "threads/copyright.h"
 
 #include <sys/types.h>
@@ -80,6 +81,102 @@ WriteOrDie(FILE *f, const char *buffer, size_t numBytes)
     }
 }
 
+static int
+CompareSymbols(const void *a, const void *b)
+{
+    const noffSymbol *x = a, *y = b;
+    return x->address < y->address ? -1 : x->address > y->address;
+}
+
+/// Copy the external procedures of the COFF symbol table, if there is one
+/// (the program may have been linked with `-s`), to the end of the NOFF
+/// file.
+///
+/// Returns the number of symbols written.
+static unsigned
+CopySymbols(FILE *in, FILE *out, const coffFileHeader *fh)
+{
+    assert(in != NULL);
+    assert(out != NULL);
+    assert(fh != NULL);
+
+    if (fh->symbolPtr == 0 || fh->nSymbols == 0) {
+        return 0;
+    }
+
+    HDRR h;
+    fseek(in, fh->symbolPtr, SEEK_SET);
+    ReadStructOrDie(in, h);
+    if (h.magic != magicSym || h.iextMax <= 0) {
+        return 0;
+    }
+
+    EXTR *externals = malloc(h.iextMax * sizeof *externals);
+    char *names = malloc(h.issExtMax);
+    if (externals == NULL || names == NULL) {
+        Die("Out of memory reading %d symbols", h.iextMax);
+    }
+    fseek(in, h.cbExtOffset, SEEK_SET);
+    ReadOrDie(in, (char *) externals, h.iextMax * sizeof *externals);
+    fseek(in, h.cbSsExtOffset, SEEK_SET);
+    ReadOrDie(in, names, h.issExtMax);
+
+    // Names may be shared, so the copies can take more room than `names`.
+    noffSymbol *symbols = malloc(h.iextMax * sizeof *symbols);
+    char *strings = NULL;
+    size_t stringsRoom = 0;
+    if (symbols == NULL) {
+        Die("Out of memory reading %d symbols", h.iextMax);
+    }
+    noffSymbolsHeader sh;
+    sh.magic       = NOFF_SYMBOLS_MAGIC;
+    sh.numSymbols  = 0;
+    sh.stringsSize = 0;
+    for (int i = 0; i < h.iextMax; i++) {
+        const SYMR *sym = &externals[i].asym;
+        if (sym->sc != scText || (sym->st != stProc
+                                    && sym->st != stStaticProc
+                                    && sym->st != stGlobal)) {
+            continue;
+        }
+        if (sym->iss < 0 || sym->iss >= h.issExtMax) {
+            continue;
+        }
+        const char *name = &names[sym->iss];
+        const char *end = memchr(name, '\0', h.issExtMax - sym->iss);
+        if (end == NULL || end == name) {
+            continue;  // Missing or unterminated name.
+        }
+        size_t length = end - name;
+        if (sh.stringsSize + length + 1 > stringsRoom) {
+            stringsRoom = 2 * (sh.stringsSize + length + 1);
+            strings = realloc(strings, stringsRoom);
+            if (strings == NULL) {
+                Die("Out of memory reading %d symbols", h.iextMax);
+            }
+        }
+        symbols[sh.numSymbols].address = sym->value;
+        symbols[sh.numSymbols].name    = sh.stringsSize;
+        memcpy(&strings[sh.stringsSize], name, length + 1);
+        sh.numSymbols++;
+        sh.stringsSize += length + 1;
+    }
+    qsort(symbols, sh.numSymbols, sizeof *symbols, CompareSymbols);
+
+    if (sh.numSymbols != 0) {
+        WriteOrDie(out, (const char *) &sh, sizeof sh);
+        WriteOrDie(out, (const char *) symbols,
+                   sh.numSymbols * sizeof *symbols);
+        WriteOrDie(out, strings, sh.stringsSize);
+    }
+
+    free(externals);
+    free(names);
+    free(symbols);
+    free(strings);
+    return sh.numSymbols;
+}
+
 void
 main(int argc, char *argv[])
 {
@@ -205,6 +302,11 @@ main(int argc, char *argv[])
         free(name);
     }
 
+    /// The symbol table goes right after the segments.
+    fseek(out, inNoffFile, SEEK_SET);
+    printf("Copied %u procedure symbols.\n",
+           CopySymbols(in, out, &d.fileH));
+
     fseek(out, 0, SEEK_SET);
     WriteOrDie(out, (const char *) &noffH, sizeof noffH);
     fclose(in);
@@ -32,5 +32,23 @@ typedef struct noffHeader {
                              // zeroed before use.
 } noffHeader;
 
+/// Optionally, the segments are followed by a table of the procedures in
+/// the program, for profiling.  It starts with this header; then come the
+/// symbols, sorted by address, and then their names, as null-terminated
+/// strings.
+
+#define NOFF_SYMBOLS_MAGIC  0x5EB01  // Magic number denoting a symbol table.
+
+typedef struct noffSymbolsHeader {
+    uint32_t magic;        // Should be `NOFF_SYMBOLS_MAGIC`.
+    uint32_t numSymbols;   // Number of symbols in the table.
+    uint32_t stringsSize;  // Size of the names, in bytes.
+} noffSymbolsHeader;
+
+typedef struct noffSymbol {
+    uint32_t address;  // Virtual address of the procedure.
+    uint32_t name;     // Offset of the name, from the start of the names.
+} noffSymbol;
+
 
 #endif
@@ -24,6 +24,45 @@ PrintSegment(noffSegment *s, const char *description)
            s->size);
 }
 
+/// Print the symbol table following the segments, if there is one.
+static void
+PrintSymbols(FILE *f, const noffHeader *h)
+{
+    uint32_t end = sizeof *h;
+    if (h->code.size != 0 && h->code.inFileAddr + h->code.size > end) {
+        end = h->code.inFileAddr + h->code.size;
+    }
+    if (h->initData.size != 0
+          && h->initData.inFileAddr + h->initData.size > end) {
+        end = h->initData.inFileAddr + h->initData.size;
+    }
+
+    noffSymbolsHeader sh;
+    if (fseek(f, end, SEEK_SET) != 0 || fread(&sh, sizeof sh, 1, f) != 1
+          || sh.magic != NOFF_SYMBOLS_MAGIC) {
+        printf("    No symbol table.\n");
+        return;
+    }
+
+    noffSymbol *symbols = malloc(sh.numSymbols * sizeof *symbols);
+    char *strings = malloc(sh.stringsSize);
+    if (symbols == NULL || strings == NULL
+          || fread(symbols, sizeof *symbols, sh.numSymbols, f)
+             != sh.numSymbols
+          || fread(strings, 1, sh.stringsSize, f) != sh.stringsSize) {
+        printf("    Truncated symbol table.\n");
+    } else {
+        printf("    Symbols (%u):\n", sh.numSymbols);
+        for (uint32_t i = 0; i < sh.numSymbols; i++) {
+            printf("        0x%08X %s\n", symbols[i].address,
+                   symbols[i].name < sh.stringsSize
+                     ? &strings[symbols[i].name] : "?");
+        }
+    }
+    free(symbols);
+    free(strings);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -62,5 +101,7 @@ main(int argc, char *argv[])
     PrintSegment(&h.code, "Code");
     PrintSegment(&h.initData, "Initialized data");
     PrintSegment(&h.uninitData, "Uninitialized data");
+    PrintSymbols(f, &h);
+    fclose(f);
     return 0;
 }
@@ -79,6 +79,75 @@ OpenFile::Write(const char *into, unsigned numBytes)
     return result;
 }
 
+int
+OpenFile::Read(const IoVec *into, unsigned count)
+{
+    int result = ReadAt(into, count, seekPosition);
+    seekPosition += result;
+    return result;
+}
+
+int
+OpenFile::Write(const IoVec *from, unsigned count)
+{
+    int result = WriteAt(from, count, seekPosition);
+    seekPosition += result;
+    return result;
+}
+
+/// Return where the next byte of the pieces of `iov` is, `*offset` bytes
+/// into piece `*piece`, moving past empty pieces; and set `left` to how
+/// many bytes follow it in the same piece.  There must be such a byte.
+static char *
+NextBytes(const IoVec *iov, unsigned *piece, unsigned *offset,
+          unsigned *left)
+{
+    while (*offset == iov[*piece].length) {
+        (*piece)++;
+        *offset = 0;
+    }
+    *left = iov[*piece].length - *offset;
+    return iov[*piece].base + *offset;
+}
+
+/// Copy `numBytes` bytes between `buffer` and the pieces of `iov`, into the
+/// pieces if `toPieces`, from `*offset` bytes into piece `*piece` on, and
+/// move past them.
+static void
+CopyPieces(const IoVec *iov, unsigned *piece, unsigned *offset,
+           char *buffer, unsigned numBytes, bool toPieces)
+{
+    while (numBytes > 0) {
+        unsigned left;
+        char *bytes = NextBytes(iov, piece, offset, &left);
+        unsigned count = min(numBytes, left);
+        if (toPieces) {
+            memcpy(bytes, buffer, count);
+        } else {
+            memcpy(buffer, bytes, count);
+        }
+        *offset  += count;
+        buffer   += count;
+        numBytes -= count;
+    }
+}
+
+/// Return how many bytes of the file, at most, a transfer of the `count`
+/// pieces of `iov` at `position` covers.
+static unsigned
+TransferLength(const IoVec *iov, unsigned count, unsigned position,
+               unsigned fileLength)
+{
+    unsigned numBytes = 0;
+    for (unsigned i = 0; i < count; i++) {
+        numBytes += iov[i].length;
+    }
+    if (position >= fileLength) {
+        return 0;
+    }
+    return min(numBytes, fileLength - position);
+}
+
 /// OpenFile::ReadAt/WriteAt
 ///
 /// Read/write a portion of a file, starting at `position`.  Return the
@@ -87,20 +156,20 @@ OpenFile::Write(const char *into, unsigned numBytes)
 ///
 /// There is no guarantee the request starts or ends on an even disk sector
 /// boundary; however the disk only knows how to read/write a whole disk
-/// sector at a time.  Thus:
+/// sector at a time.  Thus the request is carried out a sector at a time:
 ///
-/// For ReadAt:
-///     We read in all of the full or partial sectors that are part of the
-///     request, but we only copy the part we are interested in.
-/// For WriteAt:
-///     We must first read in any sectors that will be partially written, so
-///     that we do not overwrite the unmodified portion.  We then copy in the
-///     data that will be modified, and write back all the full or partial
-///     sectors that are part of the request.
+/// * A whole sector lying in a single piece of the buffer is read into, or
+///   written from, that piece directly.
+/// * Otherwise, for `ReadAt`, the sector is read into a buffer of our own,
+///   and the part we are interested in is copied out of it.
+/// * Otherwise, for `WriteAt`, a sector that is partially written is read
+///   first, so that we do not overwrite the unmodified portion; then the
+///   data that will be modified is copied in, and the sector written back.
 ///
 /// * `into` is the buffer to contain the data to be read from disk.
 /// * `from` is the buffer containing the data to be written to disk.
 /// * `numBytes` is the number of bytes to transfer.
+/// * `count` is the number of pieces in `into`/`from`, when scattered.
 /// * `position` is the offset within the file of the first byte to be
 ///   read/written.
 
@@ -110,83 +179,82 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
     ASSERT(into != nullptr);
     ASSERT(numBytes > 0);
 
-    unsigned fileLength = hdr->FileLength();
-    unsigned firstSector, lastSector, numSectors;
-    char *buf;
+    IoVec iov = { into, numBytes };
+    return ReadAt(&iov, 1, position);
+}
 
-    if (position >= fileLength) {
-        return 0;  // Check request.
-    }
-    if (position + numBytes > fileLength) {
-        numBytes = fileLength - position;
-    }
+int
+OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
+{
+    ASSERT(from != nullptr);
+    ASSERT(numBytes > 0);
+
+    IoVec iov = { (char *) from, numBytes };
+    return WriteAt(&iov, 1, position);
+}
+
+int
+OpenFile::ReadAt(const IoVec *into, unsigned count, unsigned position)
+{
+    ASSERT(into != nullptr);
+
+    unsigned fileLength = hdr->FileLength();
+    unsigned numBytes = TransferLength(into, count, position, fileLength);
     DEBUG('f', "Reading %u bytes at %u, from file of length %u.\n",
           numBytes, position, fileLength);
 
-    firstSector = DivRoundDown(position, SECTOR_SIZE);
-    lastSector = DivRoundDown(position + numBytes - 1, SECTOR_SIZE);
-    numSectors = 1 + lastSector - firstSector;
+    char buf[SECTOR_SIZE];
+    unsigned piece = 0, offset = 0;
+    for (unsigned done = 0; done < numBytes; ) {
+        unsigned sector = hdr->ByteToSector(position + done);
+        unsigned first  = (position + done) % SECTOR_SIZE;
+        unsigned size   = min(SECTOR_SIZE - first, numBytes - done);
+        unsigned left;
+        char *bytes = NextBytes(into, &piece, &offset, &left);
 
-    // Read in all the full and partial sectors that we need.
-    buf = new char [numSectors * SECTOR_SIZE];
-    for (unsigned i = firstSector; i <= lastSector; i++) {
-        synchDisk->ReadSector(hdr->ByteToSector(i * SECTOR_SIZE),
-                              &buf[(i - firstSector) * SECTOR_SIZE]);
+        if (size == SECTOR_SIZE && left >= SECTOR_SIZE) {
+            synchDisk->ReadSector(sector, bytes);
+            offset += SECTOR_SIZE;
+        } else {
+            synchDisk->ReadSector(sector, buf);
+            CopyPieces(into, &piece, &offset, &buf[first], size, true);
+        }
+        done += size;
     }
-
-    // Copy the part we want.
-    memcpy(into, &buf[position - firstSector * SECTOR_SIZE], numBytes);
-    delete [] buf;
     return numBytes;
 }
 
 int
-OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
+OpenFile::WriteAt(const IoVec *from, unsigned count, unsigned position)
 {
     ASSERT(from != nullptr);
-    ASSERT(numBytes > 0);
 
     unsigned fileLength = hdr->FileLength();
-    unsigned firstSector, lastSector, numSectors;
-    bool firstAligned, lastAligned;
-    char *buf;
-
-    if (position >= fileLength) {
-        return 0;  // Check request.
-    }
-    if (position + numBytes > fileLength) {
-        numBytes = fileLength - position;
-    }
+    unsigned numBytes = TransferLength(from, count, position, fileLength);
     DEBUG('f', "Writing %u bytes at %u, from file of length %u.\n",
           numBytes, position, fileLength);
 
-    firstSector = DivRoundDown(position, SECTOR_SIZE);
-    lastSector  = DivRoundDown(position + numBytes - 1, SECTOR_SIZE);
-    numSectors  = 1 + lastSector - firstSector;
-
-    buf = new char [numSectors * SECTOR_SIZE];
-
-    firstAligned = position == firstSector * SECTOR_SIZE;
-    lastAligned  = position + numBytes == (lastSector + 1) * SECTOR_SIZE;
-
-    // Read in first and last sector, if they are to be partially modified.
-    if (!firstAligned) {
-        ReadAt(buf, SECTOR_SIZE, firstSector * SECTOR_SIZE);
-    }
-    if (!lastAligned && (firstSector != lastSector || firstAligned)) {
-        ReadAt(&buf[(lastSector - firstSector) * SECTOR_SIZE],
-               SECTOR_SIZE, lastSector * SECTOR_SIZE);
-    }
-
-    // Copy in the bytes we want to change.
-    memcpy(&buf[position - firstSector * SECTOR_SIZE], from, numBytes);
+    char buf[SECTOR_SIZE];
+    unsigned piece = 0, offset = 0;
+    for (unsigned done = 0; done < numBytes; ) {
+        unsigned sector = hdr->ByteToSector(position + done);
+        unsigned first  = (position + done) % SECTOR_SIZE;
+        unsigned size   = min(SECTOR_SIZE - first, numBytes - done);
+        unsigned left;
+        char *bytes = NextBytes(from, &piece, &offset, &left);
 
-    // Write modified sectors back.
-    for (unsigned i = firstSector; i <= lastSector; i++) {
-        synchDisk->WriteSector(hdr->ByteToSector(i * SECTOR_SIZE),
-                               &buf[(i - firstSector) * SECTOR_SIZE]);
+        if (size == SECTOR_SIZE && left >= SECTOR_SIZE) {
+            synchDisk->WriteSector(sector, bytes);
+            offset += SECTOR_SIZE;
+        } else {
+            if (size < SECTOR_SIZE) {
+                synchDisk->ReadSector(sector, buf);
+            }
+            CopyPieces(from, &piece, &offset, &buf[first], size, false);
+            synchDisk->WriteSector(sector, buf);
+        }
+        done += size;
     }
-    delete [] buf;
     return numBytes;
 }
 
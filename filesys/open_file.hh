@@ -20,6 +20,7 @@
 #define NACHOS_FILESYS_OPENFILE__HH
 
 
+#include "lib/io_vec.hh"
 #include "lib/utility.hh"
 
 
@@ -73,6 +74,48 @@ public:
         return numWritten;
     }
 
+    int ReadAt(const IoVec *into, unsigned count, unsigned position)
+    {
+        ASSERT(into != nullptr);
+        int numRead = 0;
+        for (unsigned i = 0; i < count; i++) {
+            if (into[i].length == 0) {
+                continue;
+            }
+            int n = ReadAt(into[i].base, into[i].length, position + numRead);
+            numRead += n;
+            if (n < (int) into[i].length) {
+                break;
+            }
+        }
+        return numRead;
+    }
+    int WriteAt(const IoVec *from, unsigned count, unsigned position)
+    {
+        ASSERT(from != nullptr);
+        int numWritten = 0;
+        for (unsigned i = 0; i < count; i++) {
+            if (from[i].length == 0) {
+                continue;
+            }
+            numWritten += WriteAt(from[i].base, from[i].length,
+                                  position + numWritten);
+        }
+        return numWritten;
+    }
+    int Read(const IoVec *into, unsigned count)
+    {
+        int numRead = ReadAt(into, count, currentOffset);
+        currentOffset += numRead;
+        return numRead;
+    }
+    int Write(const IoVec *from, unsigned count)
+    {
+        int numWritten = WriteAt(from, count, currentOffset);
+        currentOffset += numWritten;
+        return numWritten;
+    }
+
     unsigned Length() const
     {
         SystemDep::Lseek(file, 0, 2);
@@ -110,6 +153,15 @@ public:
     int ReadAt(char *into, unsigned numBytes, unsigned position);
     int WriteAt(const char *from, unsigned numBytes, unsigned position);
 
+    /// Read/write bytes scattered over the `count` pieces of `into`/`from`,
+    /// in order.  Whole sectors that fall in one piece are transferred
+    /// straight into or out of it.
+
+    int Read(const IoVec *into, unsigned count);
+    int Write(const IoVec *from, unsigned count);
+    int ReadAt(const IoVec *into, unsigned count, unsigned position);
+    int WriteAt(const IoVec *from, unsigned count, unsigned position);
+
     // Return the number of bytes in the file (this interface is simpler than
     // the UNIX idiom -- `lseek` to end of file, `tell`, `lseek` back).
     unsigned Length() const;
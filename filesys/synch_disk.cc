@@ -14,6 +14,7 @@
 
 
 #include "synch_disk.hh"
+#include "threads/system.hh"
 
 
 /// Disk interrupt handler.  Need this to be a C routine, because C++ cannot
@@ -36,6 +37,7 @@ SynchDisk::SynchDisk(const char *name)
     semaphore = new Semaphore("synch disk", 0);
     lock = new Lock("synch disk lock");
     disk = new Disk(name, DiskRequestDone, this);
+    doneTicks = 0;
 }
 
 /// De-allocate data structures needed for the synchronous disk abstraction.
@@ -57,8 +59,10 @@ SynchDisk::ReadSector(int sectorNumber, char *data)
     ASSERT(data != nullptr);
 
     lock->Acquire();  // Only one disk I/O at a time.
+    unsigned long start = stats->totalTicks;
     disk->ReadRequest(sectorNumber, data);
     semaphore->P();   // Wait for interrupt.
+    currentThread->diskTicks += doneTicks - start;
     lock->Release();
 }
 
@@ -73,8 +77,10 @@ SynchDisk::WriteSector(int sectorNumber, const char *data)
     ASSERT(data != nullptr);
 
     lock->Acquire();  // only one disk I/O at a time
+    unsigned long start = stats->totalTicks;
     disk->WriteRequest(sectorNumber, data);
     semaphore->P();   // wait for interrupt
+    currentThread->diskTicks += doneTicks - start;
     lock->Release();
 }
 
@@ -83,5 +89,6 @@ SynchDisk::WriteSector(int sectorNumber, const char *data)
 void
 SynchDisk::RequestDone()
 {
+    doneTicks = stats->totalTicks;
     semaphore->V();
 }
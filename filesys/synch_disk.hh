@@ -49,6 +49,7 @@ private:
                            ///< interrupt handler.
     Lock *lock;  ///< Only one read/write request can be sent to the disk at
                  ///< a time.
+    unsigned long doneTicks;  ///< When the last request was done.
 };
 
 
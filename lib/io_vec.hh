@@ -0,0 +1,20 @@
+/// Description of a buffer scattered over several pieces of memory, so
+/// that a transfer can fill or drain all of them at once -- like UNIX
+/// `struct iovec`.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_LIB_IOVEC__HH
+#define NACHOS_LIB_IOVEC__HH
+
+
+/// One piece of a scattered buffer: `length` bytes starting at `base`.
+struct IoVec {
+    char *base;
+    unsigned length;
+};
+
+
+#endif
@@ -0,0 +1,164 @@
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 1992-1993 The Regents of the University of California.
+///               2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "decode_cache.hh"
+#include "endianness.hh"
+#include "lib/utility.hh"
+
+
+DecodeCache::DecodeCache(const char *memory_, unsigned numFrames_,
+                         unsigned frameSize_)
+{
+    ASSERT(memory_ != nullptr);
+    ASSERT(frameSize_ % 4 == 0);
+
+    memory    = memory_;
+    numFrames = numFrames_;
+    frameSize = frameSize_;
+    frames     = new Instruction * [numFrames];
+    valid      = new bool [numFrames];
+    generation = new unsigned [numFrames];
+    watched    = new bool * [numFrames];
+    for (unsigned i = 0; i < numFrames; i++) {
+        frames[i]     = nullptr;
+        valid[i]      = false;
+        generation[i] = 0;
+        watched[i]    = nullptr;
+    }
+    busy = false;
+}
+
+DecodeCache::~DecodeCache()
+{
+    for (unsigned i = 0; i < numFrames; i++) {
+        delete [] frames[i];
+        delete [] watched[i];
+    }
+    delete [] frames;
+    delete [] valid;
+    delete [] generation;
+    delete [] watched;
+}
+
+void
+DecodeCache::Invalidate(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+
+    Lock();
+    __atomic_store_n(&valid[frame], false, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&generation[frame], 1, __ATOMIC_RELAXED);
+    if (watched[frame] != nullptr) {
+        for (unsigned i = 0; i < frameSize / 4; i++) {
+            watched[frame][i] = false;
+        }
+    }
+    Unlock();
+}
+
+void
+DecodeCache::InvalidateAll()
+{
+    for (unsigned i = 0; i < numFrames; i++) {
+        Invalidate(i);
+    }
+}
+
+void
+DecodeCache::Watch(unsigned physAddr)
+{
+    unsigned frame = physAddr / frameSize;
+    ASSERT(frame < numFrames);
+
+    Lock();
+    if (watched[frame] == nullptr) {
+        watched[frame] = new bool [frameSize / 4];
+        for (unsigned i = 0; i < frameSize / 4; i++) {
+            watched[frame][i] = false;
+        }
+    }
+    watched[frame][physAddr % frameSize / 4] = true;
+    Unlock();
+}
+
+void
+DecodeCache::Lock()
+{
+    while (__atomic_test_and_set(&busy, __ATOMIC_ACQUIRE)) {}
+}
+
+void
+DecodeCache::Unlock()
+{
+    __atomic_clear(&busy, __ATOMIC_RELEASE);
+}
+
+void
+DecodeCache::Fill(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+
+    // Another processor may have decoded the frame meanwhile.
+    Lock();
+    if (valid[frame]) {
+        Unlock();
+        return;
+    }
+    if (frames[frame] == nullptr) {
+        frames[frame] = new Instruction [frameSize / 4];
+    }
+
+    Instruction *instrs = frames[frame];
+    for (unsigned i = 0; i < frameSize / 4; i++) {
+        Decode(frame * frameSize / 4 + i);
+    }
+    for (unsigned i = 0; i + 1 < frameSize / 4; i++) {
+        instrs[i].Fuse(&instrs[i + 1]);
+    }
+    __atomic_store_n(&valid[frame], true, __ATOMIC_RELEASE);
+    Unlock();
+}
+
+void
+DecodeCache::Rewrite(unsigned physAddr)
+{
+    unsigned frame = physAddr / frameSize;
+    Lock();
+    if (valid[frame]) {
+        Redecode(physAddr / 4);
+        if (watched[frame] != nullptr
+              && watched[frame][physAddr % frameSize / 4]) {
+            __atomic_fetch_add(&generation[frame], 1, __ATOMIC_RELAXED);
+        }
+    }
+    Unlock();
+}
+
+void
+DecodeCache::Decode(unsigned word)
+{
+    unsigned frame = word * 4 / frameSize;
+    Instruction *instr = &frames[frame][word % (frameSize / 4)];
+    instr->value = WordToHost(((const unsigned *) memory)[word]);
+    instr->Decode();
+}
+
+void
+DecodeCache::Redecode(unsigned word)
+{
+    unsigned frame = word * 4 / frameSize;
+    unsigned index = word % (frameSize / 4);
+    Instruction *instrs = frames[frame];
+    Decode(word);
+    if (index > 0) {
+        instrs[index - 1].Fuse(&instrs[index]);
+    }
+    if (index + 1 < frameSize / 4) {
+        instrs[index].Fuse(&instrs[index + 1]);
+    }
+}
@@ -0,0 +1,136 @@
+/// Cache of already decoded user instructions.
+///
+/// Decoding a MIPS word is cheap, but the simulator does it once per
+/// executed instruction, so tight loops end up decoding the same few words
+/// over and over again.  This cache keeps, for every physical page frame
+/// that has been executed from, an array with the decoded form of all the
+/// words in the frame.
+///
+/// The cache is indexed by physical frame, so it is shared by every address
+/// space mapping the frame and it does not need to be flushed on context
+/// switches.  It must be told whenever the contents of a frame change: the
+/// MMU does so for user stores, and the kernel must do so (through
+/// `MMU::InvalidateFrame`) whenever it writes into `mainMemory` directly or
+/// assigns a frame to a different page.
+///
+/// Decoding also marks pairs of consecutive words that can run fused (see
+/// `Instruction::Fuse`); the second word of a pair is the next element of
+/// the same array.
+///
+/// Code derived from the decoded words (such as translated blocks, see
+/// `translator.hh`) can `Watch` the words it depends on; every frame has a
+/// generation number that changes whenever the frame is invalidated or a
+/// watched word in it is written.
+///
+/// With several processors (see `userprog/multiprocessor.hh`) the cache is
+/// shared by all of them: frames are decoded, watched and invalidated under
+/// a lock, but looked up without one.  A processor must not run code that
+/// another one is storing into.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 1992-1993 The Regents of the University of California.
+///               2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_DECODECACHE__HH
+#define NACHOS_MACHINE_DECODECACHE__HH
+
+
+#include "instruction.hh"
+
+
+class DecodeCache {
+public:
+
+    /// Initialize an empty cache for `numFrames` frames of `frameSize`
+    /// bytes each, taken from `memory`.
+    DecodeCache(const char *memory, unsigned numFrames, unsigned frameSize);
+
+    /// Deallocate the decoded pages.
+    ~DecodeCache();
+
+    /// Return the decoded instruction stored at physical address
+    /// `physAddr`, decoding its whole frame first if needed.
+    ///
+    /// `physAddr` must be word aligned.
+    const Instruction *Lookup(unsigned physAddr)
+    {
+        unsigned frame = physAddr / frameSize;
+        if (!__atomic_load_n(&valid[frame], __ATOMIC_ACQUIRE)) {
+            Fill(frame);
+        }
+        return &frames[frame][physAddr % frameSize / 4];
+    }
+
+    /// Tell the cache that a user store changed the word at `physAddr`.
+    void Write(unsigned physAddr)
+    {
+        unsigned frame = physAddr / frameSize;
+        if (__atomic_load_n(&valid[frame], __ATOMIC_ACQUIRE)) {
+            Rewrite(physAddr);
+        }
+    }
+
+    /// Forget the decoded contents of `frame`, because it was changed
+    /// wholesale.
+    void Invalidate(unsigned frame);
+
+    /// Forget everything.
+    void InvalidateAll();
+
+    /// Bump the generation of the frame whenever the word at `physAddr` is
+    /// written, until the frame is next invalidated.
+    void Watch(unsigned physAddr);
+
+    unsigned Generation(unsigned frame) const
+    {
+        return __atomic_load_n(&generation[frame], __ATOMIC_RELAXED);
+    }
+
+private:
+
+    /// Take and let go of `busy`.
+    void Lock();
+    void Unlock();
+
+    /// Decode every word of `frame`.
+    void Fill(unsigned frame);
+
+    /// Decode the word with index `word` in memory, whose frame has a
+    /// decoded array.
+    void Decode(unsigned word);
+
+    /// Decode the word at `physAddr` again, in a frame that has been
+    /// decoded, and bump the generation of the frame if the word is
+    /// watched.
+    void Rewrite(unsigned physAddr);
+
+    /// Decode the word with index `word` again, after it changed, and
+    /// recompute the fusion of the pairs it belongs to.
+    void Redecode(unsigned word);
+
+    const char *memory;
+    unsigned numFrames;
+    unsigned frameSize;
+
+    /// Decoded words, one array per frame, allocated on first use.
+    Instruction **frames;
+
+    /// Whether the decoded array of each frame matches memory.
+    bool *valid;
+
+    /// Generation number of each frame.
+    unsigned *generation;
+
+    /// Held while frames are decoded, watched or invalidated, which takes
+    /// little time, so waiting for it just spins.
+    bool busy;
+
+    /// Watched words, one array per frame, allocated on first use.
+    bool **watched;
+};
+
+
+#endif
@@ -17,6 +17,7 @@ Instruction::Decode()
 {
     const OpInfo *opPtr;
 
+    fusion = FUSE_NONE;
     rs = value >> 21 & 0x1F;
     rt = value >> 16 & 0x1F;
     rd = value >> 11 & 0x1F;
@@ -65,3 +66,56 @@ Instruction::RegFromType(RegType t) const
             return -1;
     }
 }
+
+/// Whether `opCode` is an arithmetic or logic operation that cannot raise
+/// an exception.
+static bool
+IsSimpleOperation(unsigned opCode)
+{
+    switch (opCode) {
+        case OP_ADDIU: case OP_ADDU: case OP_AND: case OP_ANDI: case OP_LUI:
+        case OP_MFHI: case OP_MFLO: case OP_NOR: case OP_OR: case OP_ORI:
+        case OP_SLL: case OP_SLLV: case OP_SLT: case OP_SLTI: case OP_SLTIU:
+        case OP_SLTU: case OP_SRA: case OP_SRAV: case OP_SRL: case OP_SRLV:
+        case OP_SUBU: case OP_XOR: case OP_XORI:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// Recognize the idioms listed with the `FUSE_*` values.
+void
+Instruction::Fuse(const Instruction *next)
+{
+    ASSERT(next != nullptr);
+
+    fusion = FUSE_NONE;
+    switch (opCode) {
+        case OP_LUI:
+            if (next->rs == rt && next->opCode == OP_ORI) {
+                fusion = FUSE_LUI_ORI;
+            } else if (next->rs == rt && next->opCode == OP_ADDIU) {
+                fusion = FUSE_LUI_ADDIU;
+            }
+            break;
+
+        case OP_SLT:
+        case OP_SLTU:
+        case OP_SLTI:
+        case OP_SLTIU: {
+            unsigned result = opCode == OP_SLT || opCode == OP_SLTU ? rd : rt;
+            if ((next->opCode == OP_BEQ || next->opCode == OP_BNE)
+                  && (next->rs == result || next->rt == result)) {
+                fusion = FUSE_SET_BRANCH;
+            }
+            break;
+        }
+
+        case OP_LW:
+            if (IsSimpleOperation(next->opCode)) {
+                fusion = FUSE_LOAD_SLOT;
+            }
+            break;
+    }
+}
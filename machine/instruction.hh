@@ -10,6 +10,20 @@
 #include "encoding.hh"
 
 
+/// Pairs of consecutive instructions that the simulator can run as a single
+/// operation (see `Machine::ExecFused`).
+enum {
+    FUSE_NONE,
+    FUSE_LUI_ORI,     ///< `lui` and `ori` building a constant.
+    FUSE_LUI_ADDIU,   ///< `lui` and `addiu` building a constant or address.
+    FUSE_SET_BRANCH,  ///< `slt`, `sltu`, `slti` or `sltiu`, and `beq` or
+                      ///< `bne` testing its result.
+    FUSE_LOAD_SLOT    ///< `lw` and the arithmetic or logic instruction in
+                      ///< its load delay slot.  The second one does not
+                      ///< see the loaded value, so compiled code never
+                      ///< uses it there; the slot mostly holds a `nop`.
+};
+
 /// The following class defines an instruction, represented in both:
 /// * undecoded binary form;
 /// * decoded to identify:
@@ -25,6 +39,10 @@ public:
     /// Retrieve the register number referred to in an instruction.
     int RegFromType(RegType reg) const;
 
+    /// Set `fusion` according to the instruction that follows in memory,
+    /// `next`, already decoded.
+    void Fuse(const Instruction *next);
+
     unsigned value;  //< Binary representation of the instruction.
 
     unsigned char opCode;  ///< Type of instruction.  This is NOT the same as
@@ -33,6 +51,8 @@ public:
     unsigned char rs, rt, rd;  ///< Three registers from instruction.
     int extra;  ///< Immediate or target or shamt field or offset.
                 ///< Immediates are sign-extended.
+    unsigned char fusion;  ///< How this instruction and the next can be
+                           ///< run together; one of the `FUSE_*` values.
 };
 
 
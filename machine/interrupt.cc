@@ -148,6 +148,14 @@ Interrupt::OneTick()
 {
     MachineStatus old = status;
 
+#ifdef USER_PROGRAM
+    // Other processors waiting for the kernel get it now, as if their
+    // interrupts were serviced at this point.
+    if (multiprocessor != nullptr && status == SYSTEM_MODE) {
+        multiprocessor->Preempt();
+    }
+#endif
+
     // Advance simulated time.
     if (status == SYSTEM_MODE) {
         stats->totalTicks += SYSTEM_TICK;
@@ -172,6 +180,50 @@ Interrupt::OneTick()
     }
 }
 
+/// Return how many user instructions can run before the first pending
+/// interrupt is due; `ULONG_MAX` if nothing is pending.
+unsigned long
+Interrupt::UserTicksBeforeDue() const
+{
+    if (pending->IsEmpty()) {
+        return ULONG_MAX;
+    }
+
+    // Only the head of the list is checked by `CheckIfDue`.
+    unsigned long when = pending->Head()->when;
+    if (when <= stats->totalTicks) {
+        return 0;
+    }
+    return (when - stats->totalTicks - 1) / USER_TICK;
+}
+
+/// Advance simulated time as `n` calls to `OneTick` in user mode would,
+/// when no interrupt becomes due meanwhile (see `UserTicksBeforeDue`).
+void
+Interrupt::AdvanceUserTicks(unsigned long n)
+{
+    ASSERT(status == USER_MODE);
+
+    stats->totalTicks += n * USER_TICK;
+    stats->userTicks  += n * USER_TICK;
+}
+
+void
+Interrupt::SetTime(unsigned long now)
+{
+    List<PendingInterrupt *> *oldPending = pending;
+    pending = new List<PendingInterrupt *>;
+
+    PendingInterrupt *i;
+    while ((i = oldPending->SortedPop(nullptr)) != nullptr) {
+        i->when = i->when - stats->totalTicks + now;
+        pending->SortedInsert(i, i->when);
+    }
+
+    delete oldPending;
+    stats->totalTicks = now;
+}
+
 /// Called from within an interrupt handler, to cause a context switch (for
 /// example, on a time slice) in the interrupted thread, when the handler
 /// returns.
@@ -222,6 +274,13 @@ Interrupt::Idle()
 void
 Interrupt::Halt()
 {
+#ifdef USER_PROGRAM
+    // Instructions that other processors ran since they last entered the
+    // kernel are not counted.
+    if (multiprocessor != nullptr) {
+        multiprocessor->Stop();
+    }
+#endif
     printf("Machine halting!\n\n");
     stats->Print();
     Cleanup();  // Never returns.
@@ -372,6 +431,15 @@ Interrupt::SetStatus(MachineStatus st)
     status = st;
 }
 
+void
+Interrupt::SetState(IntStatus now, MachineStatus st)
+{
+    ASSERT(IsIntStatus(now));
+
+    level  = now;
+    status = st;
+}
+
 /// Print information about an interrupt that is scheduled to occur.  When,
 /// where, why, etc.
 static void
@@ -127,6 +127,11 @@ public:
 
     void SetStatus(MachineStatus st);
 
+    /// Set both the interrupt level and the status, without advancing
+    /// simulated time, as another processor takes over the kernel (see
+    /// `userprog/multiprocessor.hh`).
+    void SetState(IntStatus now, MachineStatus st);
+
     // Print interrupt state.
     void DumpState();
 
@@ -145,6 +150,22 @@ public:
     /// Advance simulated time.
     void OneTick();
 
+    /// Return how many user instructions can be executed before any
+    /// pending interrupt becomes due.
+    ///
+    /// That many calls to `OneTick` in user mode would do nothing but
+    /// advance the clock, so a simulator running them in a batch can call
+    /// `AdvanceUserTicks` instead.
+    unsigned long UserTicksBeforeDue() const;
+
+    /// Account for `n` user instructions executed without interrupts.
+    void AdvanceUserTicks(unsigned long n);
+
+    /// Set the simulated time to `now`, as when resuming from a checkpoint.
+    ///
+    /// Pending interrupts stay as far in the future as they were.
+    void SetTime(unsigned long now);
+
 private:
     IntStatus level;  ///< Are interrupts enabled or disabled?
     List<PendingInterrupt *> *pending;  ///< The list of interrupts scheduled
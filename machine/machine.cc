@@ -45,7 +45,9 @@ CheckEndian()
 /// * `st` -- pointer to an object that performs single stepping, for
 ///   dropping into it after each user instruction is executed; if null,
 ///   execute normally, without single stepping.
-Machine::Machine(SingleStepper *st)
+/// * `numPhysPages` -- number of frames of physical memory.
+Machine::Machine(SingleStepper *st, unsigned numPhysPages)
+    : mmu(numPhysPages)
 {
     for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
         registers[i] = 0;
@@ -56,7 +58,39 @@ Machine::Machine(SingleStepper *st)
     }
 
     singleStepper = st;
+    tickBudget = 0;
+    ticksRun = 0;
+    userMode = false;
+    profile = nullptr;
     CheckEndian();
+
+#ifdef MIPS_JIT
+    translator = new Translator(this, mmu.GetDecodeCache(),
+                                mmu.GetNumPhysPages(), PAGE_SIZE);
+#endif
+}
+
+Machine::Machine(Machine *boot)
+    : mmu(boot->GetMMU())
+{
+    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
+        registers[i] = 0;
+    }
+
+    for (unsigned i = 0; i < NUM_EXCEPTION_TYPES; i++) {
+        handlers[i] = boot->handlers[i];
+    }
+
+    singleStepper = nullptr;
+    tickBudget = 0;
+    ticksRun = 0;
+    userMode = false;
+    profile = nullptr;
+
+#ifdef MIPS_JIT
+    translator = new Translator(this, mmu.GetDecodeCache(),
+                                mmu.GetNumPhysPages(), PAGE_SIZE);
+#endif
 }
 
 const int *
@@ -91,9 +125,25 @@ Machine::WriteRegister(unsigned num, int value)
     }
 }
 
+void
+Machine::SetProfile(Profile *p)
+{
+    profile = p;
+}
+
+Profile *
+Machine::GetProfile() const
+{
+    return profile;
+}
+
 bool
 Machine::ReadMem(unsigned addr, unsigned size, int *value)
 {
+    if (profile != nullptr && userMode) {
+        profile->CountAccess(registers[PC_REG]);
+    }
+
     ExceptionType e = mmu.ReadMem(addr, size, value);
     if (e != NO_EXCEPTION) {
         RaiseException(e, addr);
@@ -105,6 +155,10 @@ Machine::ReadMem(unsigned addr, unsigned size, int *value)
 bool
 Machine::WriteMem(unsigned addr, unsigned size, int value)
 {
+    if (profile != nullptr && userMode) {
+        profile->CountAccess(registers[PC_REG]);
+    }
+
     ExceptionType e = mmu.WriteMem(addr, size, value);
     if (e != NO_EXCEPTION) {
         RaiseException(e, addr);
@@ -125,16 +179,73 @@ Machine::RaiseException(ExceptionType et, unsigned badVAddr)
     ASSERT(IsExceptionType(et));
     ASSERT(handlers[et] != nullptr);  // There must be a handler associated.
 
+    // The kernel itself may fault, when it touches user memory; then it is
+    // already in.
+    bool fromUser = userMode;
+    if (fromUser) {
+        EnterKernel();
+    }
+
     DEBUG('m', "Exception: %s\n", ExceptionTypeToString(et));
+    if (profile != nullptr) {
+        profile->CountException(et);
+    }
+    if (et == SYSCALL_EXCEPTION) {
+        stats->numSyscalls++;
+    }
 
     //ASSERT(interrupt->GetStatus() == USER_MODE);
     registers[BAD_VADDR_REG] = badVAddr;
     DelayedLoad(0, 0);  // Finish anything in progress.
 
+    // The handler may schedule interrupts, and other threads may run
+    // before it returns.
+    tickBudget = 0;
+
     // Call the associated handler with interrupts enabled in system mode.
+    MachineStatus status = interrupt->GetStatus();
     interrupt->SetStatus(SYSTEM_MODE);
     (*handlers[et])(et);
-    interrupt->SetStatus(USER_MODE);
+    interrupt->SetStatus(status);
+    if (fromUser) {
+        LeaveKernel();
+    } else {
+        tickBudget = 0;
+    }
+}
+
+void
+Machine::EnterKernel()
+{
+    ASSERT(userMode);
+
+    userMode = false;
+    if (multiprocessor != nullptr) {
+        multiprocessor->Lock();
+    }
+    FlushTicks();
+}
+
+void
+Machine::LeaveKernel()
+{
+    ASSERT(!userMode);
+
+    // With `i` debugging, every tick is traced by `OneTick`.
+    tickBudget = debug.IsEnabled('i') ? 0 : interrupt->UserTicksBeforeDue();
+    if (multiprocessor != nullptr) {
+        tickBudget = multiprocessor->Unlock(tickBudget);
+    }
+    userMode = true;
+}
+
+void
+Machine::FlushTicks()
+{
+    if (ticksRun > 0) {
+        interrupt->AdvanceUserTicks(ticksRun);
+        ticksRun = 0;
+    }
 }
 
 void
@@ -23,7 +23,9 @@
 
 #include "exception_type.hh"
 #include "mmu.hh"
+#include "profile.hh"
 #include "single_stepper.hh"
+#include "translator.hh"
 #include "lib/utility.hh"
 
 
@@ -67,8 +69,14 @@ typedef void (*ExceptionHandler)(ExceptionType);
 class Machine {
 public:
 
-    /// Initialize the simulation of the hardware for running user programs.
-    Machine(SingleStepper *st);
+    /// Initialize the simulation of the hardware for running user programs,
+    /// with `numPhysPages` frames of physical memory.
+    Machine(SingleStepper *st,
+            unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES);
+
+    /// Initialize another processor, sharing the physical memory and the
+    /// exception handlers of `boot` (see `userprog/multiprocessor.hh`).
+    Machine(Machine *boot);
 
     /// Routines callable by the Nachos kernel.
 
@@ -95,16 +103,58 @@ public:
     /// Print the user CPU and memory state.
     void DumpState();
 
+    /// Count what the running program does into `p`; if null, stop
+    /// counting.
+    ///
+    /// While there is a profile, every instruction is interpreted one by
+    /// one.
+    void SetProfile(Profile *p);
+
+    Profile *GetProfile() const;
+
     /// Routines internal to the machine simulation -- DO NOT call these.
 
-    /// Fetch one instruction of a user program.
+    /// Fetch one instruction of a user program, already decoded.
     ///
     /// Return false if an exception occurs, true otherwise.
-    bool FetchInstruction(Instruction *instr);
+    bool FetchInstruction(const Instruction **instr);
 
     /// Run a certain instruction of a user program.
     void ExecInstruction(const Instruction *instr);
 
+    /// Run the pair of instructions that starts with `instr`, fused by the
+    /// decoder, as `ExecInstruction` and `Tick` would run them one by one.
+    ///
+    /// Only for use outside of delay slots, when `Tick` will not run
+    /// `Interrupt::OneTick`.
+    void ExecFused(const Instruction *instr);
+
+    /// Advance simulated time after running a user instruction.
+    ///
+    /// This has the same effect as `Interrupt::OneTick`, but it only calls
+    /// it when an interrupt may be due.
+    void Tick();
+
+    /// Account for `n` user instructions run without calling `Tick`, which
+    /// must fit in the budget.
+    void CountTicks(unsigned long n)
+    {
+        ticksRun   += n;
+        tickBudget -= n;
+    }
+
+#ifdef THREADED_DISPATCH
+    /// Run user instructions forever, dispatching through a table of
+    /// per-opcode handlers instead of `ExecInstruction`.
+    void RunThreaded();
+#endif
+
+#ifdef MIPS_JIT
+    /// Run user instructions forever, running translated blocks of them
+    /// when possible (see `translator.hh`).
+    void RunTranslated();
+#endif
+
     /// Do a pending delayed load (modifying a reg).
     void DelayedLoad(unsigned nextReg, int nextVal);
 
@@ -121,6 +171,22 @@ public:
     void SetHandler(ExceptionType et, ExceptionHandler handler);
 
 private:
+
+    /// Enter the kernel from user code, taking the kernel lock if there
+    /// are several processors, and bring simulated time up to date.
+    void EnterKernel();
+
+    /// Go back to user code: compute the tick budget, and let go of the
+    /// kernel lock if there are several processors.
+    void LeaveKernel();
+
+    /// Add the ticks run since the kernel was entered to simulated time.
+    void FlushTicks();
+
+    /// End an instruction: do the pending delayed load, start the one of
+    /// this instruction, if any, and advance the program counters.
+    void Retire(unsigned nextLoadReg, int nextLoadValue, int pcAfter);
+
     SingleStepper *singleStepper;  ///< Drop back into the method of a
                                    ///< provided object (may be a debugger)
                                    ///< after each simulated instruction.
@@ -131,7 +197,25 @@ private:
 
     MMU mmu; ///< Memory management unit.
 
+    unsigned long tickBudget;  ///< User instructions that can still run
+                               ///< before an interrupt may be due.  Zero
+                               ///< whenever the kernel may have scheduled
+                               ///< something.
+
+    unsigned long ticksRun;  ///< User instructions run since simulated
+                             ///< time was last advanced.  Another
+                             ///< processor may be in the kernel, so the
+                             ///< ticks are only added on the way in.
+
+    bool userMode;  ///< Whether user code is running, outside the kernel.
+
+#ifdef MIPS_JIT
+    Translator *translator;  ///< Translated blocks of user code.
+#endif
+
     ExceptionHandler handlers[NUM_EXCEPTION_TYPES];  ///< Exception handlers.
+
+    Profile *profile;  ///< Profile of the running program, if any.
 };
 
 
@@ -27,25 +27,81 @@
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;
-      // Storage for decoded instruction.
+    const Instruction *instr;
+      // Decoded instruction, owned by the MMU's decode cache.
+    bool fuse = singleStepper == nullptr && profile == nullptr
+                && !debug.IsEnabled('m') && !debug.IsEnabled('a');
+      // Whether fused pairs can run, as nobody looks in between.
 
     if (debug.IsEnabled('m')) {
         printf("Starting to run at time %lu\n", stats->totalTicks);
     }
     interrupt->SetStatus(USER_MODE);
+    LeaveKernel();
+
+#ifdef MIPS_JIT
+    // Translated blocks neither trace nor stop between instructions.
+    if (singleStepper == nullptr && profile == nullptr
+          && !debug.IsEnabled('m') && !debug.IsEnabled('a')
+          && !debug.IsEnabled('i')) {
+        RunTranslated();
+    }
+#endif
+
+#ifdef THREADED_DISPATCH
+    if (profile == nullptr) {
+        RunThreaded();
+    }
+#endif
 
     for (;;) {
-        if (FetchInstruction(instr)) {
-            ExecInstruction(instr);
+        if (FetchInstruction(&instr)) {
+            if (profile != nullptr) {
+                profile->CountInstruction(registers[PC_REG]);
+            }
+            if (instr->fusion != FUSE_NONE && fuse && tickBudget > 0
+                  && registers[NEXT_PC_REG] == registers[PC_REG] + 4) {
+                ExecFused(instr);
+            } else {
+                ExecInstruction(instr);
+            }
         }
-        interrupt->OneTick();
-        if (singleStepper != nullptr && !singleStepper->Step()) {
-            singleStepper = nullptr;
+        Tick();
+        if (singleStepper != nullptr) {
+            FlushTicks();
+            if (!singleStepper->Step()) {
+                singleStepper = nullptr;
+            }
         }
     }
 }
 
+/// Run `Interrupt::OneTick` only when the first pending interrupt may be
+/// due; until then, just account for the instruction.
+///
+/// Nothing but the kernel can schedule interrupts, so the budget is only
+/// recomputed after `OneTick` (which runs interrupt handlers and may switch
+/// threads), and after exceptions (see `RaiseException`).
+///
+/// With several processors, the budget also ends every time slice, and the
+/// thread yields the processor.
+void
+Machine::Tick()
+{
+    if (tickBudget > 0) {
+        tickBudget--;
+        ticksRun++;
+        return;
+    }
+
+    EnterKernel();
+    if (multiprocessor != nullptr) {
+        interrupt->YieldOnReturn();
+    }
+    interrupt->OneTick();
+    LeaveKernel();
+}
+
 /// Simulate effects of a delayed load.
 ///
 /// NOTE -- `RaiseException`/`CheckInterrupts` must also call `DelayedLoad`,
@@ -60,25 +116,25 @@ Machine::DelayedLoad(unsigned nextReg, int nextValue)
 }
 
 bool
-Machine::FetchInstruction(Instruction *instr)
+Machine::FetchInstruction(const Instruction **instr)
 {
     ASSERT(instr != nullptr);
 
-    int raw;
-    if (!ReadMem(registers[PC_REG], 4, &raw)) {
+    ExceptionType e = mmu.ReadInstruction(registers[PC_REG], instr);
+    if (e != NO_EXCEPTION) {
+        RaiseException(e, registers[PC_REG]);
         return false;  // Exception occurred.
     }
-    instr->value = raw;
-    instr->Decode();
 
     if (debug.IsEnabled('m')) {
-        const struct OpString *str = &OP_STRINGS[instr->opCode];
+        const Instruction *i = *instr;
+        const struct OpString *str = &OP_STRINGS[i->opCode];
 
-        ASSERT(instr->opCode <= MAX_OPCODE);
+        ASSERT(i->opCode <= MAX_OPCODE);
         DEBUG('m', "At PC = 0x%X: ", registers[PC_REG]);
-        DEBUG_CONT('m', str->string, instr->RegFromType(str->args[0]),
-                        instr->RegFromType(str->args[1]),
-                        instr->RegFromType(str->args[2]));
+        DEBUG_CONT('m', str->string, i->RegFromType(str->args[0]),
+                        i->RegFromType(str->args[1]),
+                        i->RegFromType(str->args[2]));
         DEBUG_CONT('m', "\n");
     }
     return true;
@@ -643,7 +699,12 @@ Machine::ExecInstruction(const Instruction *instr)
     }
 
     // Now we have successfully executed the instruction.
+    Retire(nextLoadReg, nextLoadValue, pcAfter);
+}
 
+void
+Machine::Retire(unsigned nextLoadReg, int nextLoadValue, int pcAfter)
+{
     // Do any delayed load operation.
     DelayedLoad(nextLoadReg, nextLoadValue);
 
@@ -653,3 +714,595 @@ Machine::ExecInstruction(const Instruction *instr)
     registers[PC_REG] = registers[NEXT_PC_REG];
     registers[NEXT_PC_REG] = pcAfter;
 }
+
+/// The second instruction of the pair is not fetched: it is the next one in
+/// the decoded frame.  The first instruction of a pair never writes memory,
+/// so it cannot change the second one either.
+void
+Machine::ExecFused(const Instruction *instr)
+{
+    const Instruction *second = instr + 1;
+    int value = 0;
+    unsigned rs, imm;
+
+    // The first instruction.
+    switch (instr->fusion) {
+        case FUSE_LUI_ORI:
+        case FUSE_LUI_ADDIU:
+            registers[instr->rt] = instr->extra << 16;
+            Retire(0, 0, registers[NEXT_PC_REG] + 4);
+            break;
+
+        case FUSE_SET_BRANCH:
+            switch (instr->opCode) {
+                case OP_SLT:
+                    registers[instr->rd] = registers[instr->rs]
+                                           < registers[instr->rt];
+                    break;
+                case OP_SLTU:
+                    rs = registers[instr->rs];
+                    imm = registers[instr->rt];
+                    registers[instr->rd] = rs < imm;
+                    break;
+                case OP_SLTI:
+                    registers[instr->rt] = registers[instr->rs] < instr->extra;
+                    break;
+                case OP_SLTIU:
+                    rs = registers[instr->rs];
+                    imm = instr->extra;
+                    registers[instr->rt] = rs < imm;
+                    break;
+                default:
+                    ASSERT(false);
+            }
+            Retire(0, 0, registers[NEXT_PC_REG] + 4);
+            break;
+
+        case FUSE_LOAD_SLOT: {
+            int addr = registers[instr->rs] + instr->extra;
+            if (addr & 0x3) {
+                RaiseException(ADDRESS_ERROR_EXCEPTION, addr);
+                return;
+            }
+            if (!ReadMem(addr, 4, &value)) {
+                return;
+            }
+            Retire(instr->rt, value, registers[NEXT_PC_REG] + 4);
+            break;
+        }
+
+        default:
+            ASSERT(false);
+    }
+    Tick();
+
+    // The second one.
+    switch (instr->fusion) {
+        case FUSE_LUI_ORI:
+            registers[second->rt] = registers[second->rs]
+                                    | (second->extra & 0xFFFF);
+            Retire(0, 0, registers[NEXT_PC_REG] + 4);
+            break;
+
+        case FUSE_LUI_ADDIU:
+            registers[second->rt] = registers[second->rs] + second->extra;
+            Retire(0, 0, registers[NEXT_PC_REG] + 4);
+            break;
+
+        case FUSE_SET_BRANCH:
+            if ((registers[second->rs] == registers[second->rt])
+                  == (second->opCode == OP_BEQ)) {
+                Retire(0, 0, registers[NEXT_PC_REG]
+                             + IndexToAddr(second->extra));
+            } else {
+                Retire(0, 0, registers[NEXT_PC_REG] + 4);
+            }
+            break;
+
+        case FUSE_LOAD_SLOT:
+            ExecInstruction(second);
+            break;
+    }
+}
+
+#ifdef THREADED_DISPATCH
+
+#ifndef __GNUC__
+#error "THREADED_DISPATCH needs the labels-as-values extension of GCC/Clang."
+#endif
+
+/// Execute user instructions forever, with direct-threaded dispatch.
+///
+/// This is an alternative to the `FetchInstruction`/`ExecInstruction` loop
+/// in `Run`, and must behave exactly like it, tick for tick.  Every opcode
+/// has its own handler, and every handler ends by fetching the next
+/// instruction and jumping straight to its handler, so there is neither a
+/// bounds-checked `switch` nor a return to a central loop.
+///
+/// Handlers for instructions that do not load skip `DelayedLoad` and only
+/// retire the pending load, if there is one.
+///
+/// Like `ExecInstruction`, nothing is cached across instructions: the
+/// handlers always work on `registers` and go through the MMU, so the
+/// kernel may switch threads from any exception or interrupt.
+void
+Machine::RunThreaded()
+{
+    // Indexed by the `OP_*` values from `encoding.hh`.
+    static const void *const HANDLERS[MAX_OPCODE + 1] = {
+        &&BAD,    &&ADD,    &&ADDI,   &&ADDIU,  &&ADDU,   &&AND,
+        &&ANDI,   &&BEQ,    &&BGEZ,   &&BGEZAL, &&BGTZ,   &&BLEZ,
+        &&BLTZ,   &&BLTZAL, &&BNE,    &&BAD,    &&DIV,    &&DIVU,
+        &&J,      &&JAL,    &&JALR,   &&JR,     &&LB,     &&LBU,
+        &&LH,     &&LHU,    &&LUI,    &&LW,     &&LWL,    &&LWR,
+        &&BAD,    &&MFHI,   &&MFLO,   &&BAD,    &&MTHI,   &&MTLO,
+        &&MULT,   &&MULTU,  &&NOR,    &&OR,     &&ORI,    &&BAD,
+        &&SB,     &&SH,     &&SLL,    &&SLLV,   &&SLT,    &&SLTI,
+        &&SLTIU,  &&SLTU,   &&SRA,    &&SRAV,   &&SRL,    &&SRLV,
+        &&SUB,    &&SUBU,   &&SW,     &&SWL,    &&SWR,    &&XOR,
+        &&XORI,   &&SYSCALL, &&ILLEGAL, &&ILLEGAL
+    };
+
+    const Instruction *instr;
+    int      sum, diff, tmp, value, nextLoadValue, pcAfter;
+    unsigned rs, rt, imm;
+
+// Registers named by the current instruction.
+#define RS  registers[instr->rs]
+#define RT  registers[instr->rt]
+#define RD  registers[instr->rd]
+
+// The branch target of the current instruction.
+#define BRANCH_TARGET  (registers[NEXT_PC_REG] + IndexToAddr(instr->extra))
+
+// Run one tick, then fetch the next instruction and jump to its handler.
+#define DISPATCH()                                                   \
+    do {                                                             \
+        Tick();                                                      \
+        if (singleStepper != nullptr) {                              \
+            FlushTicks();                                            \
+            if (!singleStepper->Step()) {                            \
+                singleStepper = nullptr;                             \
+            }                                                        \
+        }                                                            \
+        if (!FetchInstruction(&instr)) {                             \
+            goto TICK;                                               \
+        }                                                            \
+        goto *HANDLERS[instr->opCode];                               \
+    } while (0)
+
+// Advance the program counters, with `pcAfter` as the new next PC.
+#define ADVANCE(pcAfter)                                             \
+    do {                                                             \
+        registers[PREV_PC_REG] = registers[PC_REG];                  \
+        registers[PC_REG] = registers[NEXT_PC_REG];                  \
+        registers[NEXT_PC_REG] = (pcAfter);                          \
+    } while (0)
+
+// Finish an instruction that does not load: same as `DelayedLoad(0, 0)`.
+// The next PC is worked out first, as branches and jumps must still see
+// the register that a load in the previous instruction is writing.
+#define RETIRE(next)                                                 \
+    do {                                                             \
+        pcAfter = (next);                                            \
+        if (registers[LOAD_REG] != 0) {                              \
+            registers[registers[LOAD_REG]] = registers[LOAD_VALUE_REG];\
+            registers[LOAD_REG] = 0;                                 \
+        }                                                            \
+        registers[LOAD_VALUE_REG] = 0;                               \
+        registers[0] = 0;                                            \
+        ADVANCE(pcAfter);                                            \
+        DISPATCH();                                                  \
+    } while (0)
+
+// Finish a load of `value` into the `rt` register.
+#define RETIRE_LOAD(value)                                           \
+    do {                                                             \
+        DelayedLoad(instr->rt, (value));                             \
+        ADVANCE(registers[NEXT_PC_REG] + 4);                         \
+        DISPATCH();                                                  \
+    } while (0)
+
+#define SEQUENTIAL  (registers[NEXT_PC_REG] + 4)
+
+    // The first instruction.
+    if (!FetchInstruction(&instr)) {
+        goto TICK;
+    }
+    goto *HANDLERS[instr->opCode];
+
+TICK:  // After an exception, go on with the next instruction.
+    DISPATCH();
+
+ADD:
+    sum = RS + RT;
+    if (!((RS ^ RT) & SIGN_BIT) && (RS ^ sum) & SIGN_BIT) {
+        RaiseException(OVERFLOW_EXCEPTION, 0);
+        goto TICK;
+    }
+    RD = sum;
+    RETIRE(SEQUENTIAL);
+
+ADDI:
+    sum = RS + instr->extra;
+    if (!((RS ^ instr->extra) & SIGN_BIT) && (instr->extra ^ sum) & SIGN_BIT) {
+        RaiseException(OVERFLOW_EXCEPTION, 0);
+        goto TICK;
+    }
+    RT = sum;
+    RETIRE(SEQUENTIAL);
+
+ADDIU:
+    RT = RS + instr->extra;
+    RETIRE(SEQUENTIAL);
+
+ADDU:
+    RD = RS + RT;
+    RETIRE(SEQUENTIAL);
+
+AND:
+    RD = RS & RT;
+    RETIRE(SEQUENTIAL);
+
+ANDI:
+    RT = RS & (instr->extra & 0xFFFF);
+    RETIRE(SEQUENTIAL);
+
+BEQ:
+    RETIRE(RS == RT ? BRANCH_TARGET : SEQUENTIAL);
+
+BGEZAL:
+    registers[RET_ADDR_REG] = registers[NEXT_PC_REG] + 4;
+    // Fall through.
+BGEZ:
+    RETIRE(!(RS & SIGN_BIT) ? BRANCH_TARGET : SEQUENTIAL);
+
+BGTZ:
+    RETIRE(RS > 0 ? BRANCH_TARGET : SEQUENTIAL);
+
+BLEZ:
+    RETIRE(RS <= 0 ? BRANCH_TARGET : SEQUENTIAL);
+
+BLTZAL:
+    registers[RET_ADDR_REG] = registers[NEXT_PC_REG] + 4;
+    // Fall through.
+BLTZ:
+    RETIRE(RS & SIGN_BIT ? BRANCH_TARGET : SEQUENTIAL);
+
+BNE:
+    RETIRE(RS != RT ? BRANCH_TARGET : SEQUENTIAL);
+
+DIV:
+    if (RT == 0) {
+        registers[LO_REG] = 0;
+        registers[HI_REG] = 0;
+    } else {
+        registers[LO_REG] = RS / RT;
+        registers[HI_REG] = RS % RT;
+    }
+    RETIRE(SEQUENTIAL);
+
+DIVU:
+    rs = (unsigned) RS;
+    rt = (unsigned) RT;
+    if (rt == 0) {
+        registers[LO_REG] = 0;
+        registers[HI_REG] = 0;
+    } else {
+        tmp = rs / rt;
+        registers[LO_REG] = (int) tmp;
+        tmp = rs % rt;
+        registers[HI_REG] = (int) tmp;
+    }
+    RETIRE(SEQUENTIAL);
+
+JAL:
+    registers[RET_ADDR_REG] = registers[NEXT_PC_REG] + 4;
+    // Fall through.
+J:
+    RETIRE((SEQUENTIAL & 0xF0000000) | IndexToAddr(instr->extra));
+
+JALR:
+    RD = registers[NEXT_PC_REG] + 4;
+    // Fall through.
+JR:
+    RETIRE(RS);
+
+LB:
+    if (!ReadMem(RS + instr->extra, 1, &value)) {
+        goto TICK;
+    }
+    RETIRE_LOAD(value & 0x80 ? value | 0xFFFFFF00 : value & 0xFF);
+
+LBU:
+    if (!ReadMem(RS + instr->extra, 1, &value)) {
+        goto TICK;
+    }
+    RETIRE_LOAD(value & 0xFF);
+
+LH:
+    tmp = RS + instr->extra;
+    if (tmp & 0x1) {
+        RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
+        goto TICK;
+    }
+    if (!ReadMem(tmp, 2, &value)) {
+        goto TICK;
+    }
+    RETIRE_LOAD(value & 0x8000 ? value | 0xFFFF0000 : value & 0xFFFF);
+
+LHU:
+    tmp = RS + instr->extra;
+    if (tmp & 0x1) {
+        RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
+        goto TICK;
+    }
+    if (!ReadMem(tmp, 2, &value)) {
+        goto TICK;
+    }
+    RETIRE_LOAD(value & 0xFFFF);
+
+LUI:
+    DEBUG('m', "Executing: LUI r%d,%d\n", instr->rt, instr->extra);
+    RT = instr->extra << 16;
+    RETIRE(SEQUENTIAL);
+
+LW:
+    tmp = RS + instr->extra;
+    if (tmp & 0x3) {
+        RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
+        goto TICK;
+    }
+    if (!ReadMem(tmp, 4, &value)) {
+        goto TICK;
+    }
+    RETIRE_LOAD(value);
+
+LWL:
+    tmp = RS + instr->extra;
+    ASSERT((tmp & 0x3) == 0);  // See `ExecInstruction`.
+    if (!ReadMem(tmp, 4, &value)) {
+        goto TICK;
+    }
+    nextLoadValue = registers[LOAD_REG] == instr->rt
+                    ? registers[LOAD_VALUE_REG] : RT;
+    switch (tmp & 0x3) {
+        case 0:
+            nextLoadValue = value;
+            break;
+        case 1:
+            nextLoadValue = (nextLoadValue & 0xFF) | value << 8;
+            break;
+        case 2:
+            nextLoadValue = (nextLoadValue & 0xFFFF) | value << 16;
+            break;
+        case 3:
+            nextLoadValue = (nextLoadValue & 0xFFFFFF) | value << 24;
+            break;
+    }
+    RETIRE_LOAD(nextLoadValue);
+
+LWR:
+    tmp = RS + instr->extra;
+    ASSERT((tmp & 0x3) == 0);  // See `ExecInstruction`.
+    if (!ReadMem(tmp, 4, &value)) {
+        goto TICK;
+    }
+    nextLoadValue = registers[LOAD_REG] == instr->rt
+                    ? registers[LOAD_VALUE_REG] : RT;
+    switch (tmp & 0x3) {
+        case 0:
+            nextLoadValue = (nextLoadValue & 0xFFFFFF00)
+                            | (value >> 24 & 0xFF);
+            break;
+        case 1:
+            nextLoadValue = (nextLoadValue & 0xFFFF0000)
+                            | (value >> 16 & 0xFFFF);
+            break;
+        case 2:
+            nextLoadValue = (nextLoadValue & 0xFF000000)
+                            | (value >> 8 & 0xFFFFFF);
+            break;
+        case 3:
+            nextLoadValue = value;
+            break;
+    }
+    RETIRE_LOAD(nextLoadValue);
+
+MFHI:
+    RD = registers[HI_REG];
+    RETIRE(SEQUENTIAL);
+
+MFLO:
+    RD = registers[LO_REG];
+    RETIRE(SEQUENTIAL);
+
+MTHI:
+    registers[HI_REG] = RS;
+    RETIRE(SEQUENTIAL);
+
+MTLO:
+    registers[LO_REG] = RS;
+    RETIRE(SEQUENTIAL);
+
+MULT:
+    Mult(RS, RT, true, &registers[HI_REG], &registers[LO_REG]);
+    RETIRE(SEQUENTIAL);
+
+MULTU:
+    Mult(RS, RT, false, &registers[HI_REG], &registers[LO_REG]);
+    RETIRE(SEQUENTIAL);
+
+NOR:
+    RD = ~(RS | RT);
+    RETIRE(SEQUENTIAL);
+
+OR:
+    RD = RS | RT;
+    RETIRE(SEQUENTIAL);
+
+ORI:
+    RT = RS | (instr->extra & 0xFFFF);
+    RETIRE(SEQUENTIAL);
+
+SB:
+    if (!WriteMem((unsigned) (RS + instr->extra), 1, RT)) {
+        goto TICK;
+    }
+    RETIRE(SEQUENTIAL);
+
+SH:
+    if (!WriteMem((unsigned) (RS + instr->extra), 2, RT)) {
+        goto TICK;
+    }
+    RETIRE(SEQUENTIAL);
+
+SLL:
+    RD = RT << instr->extra;
+    RETIRE(SEQUENTIAL);
+
+SLLV:
+    RD = RT << (RS & 0x1F);
+    RETIRE(SEQUENTIAL);
+
+SLT:
+    RD = RS < RT ? 1 : 0;
+    RETIRE(SEQUENTIAL);
+
+SLTI:
+    RT = RS < instr->extra ? 1 : 0;
+    RETIRE(SEQUENTIAL);
+
+SLTIU:
+    rs = RS;
+    imm = instr->extra;
+    RT = rs < imm ? 1 : 0;
+    RETIRE(SEQUENTIAL);
+
+SLTU:
+    rs = RS;
+    rt = RT;
+    RD = rs < rt ? 1 : 0;
+    RETIRE(SEQUENTIAL);
+
+SRA:
+    RD = RT >> instr->extra;
+    RETIRE(SEQUENTIAL);
+
+SRAV:
+    RD = RT >> (RS & 0x1F);
+    RETIRE(SEQUENTIAL);
+
+SRL:
+    tmp = RT;
+    tmp >>= instr->extra;
+    RD = tmp;
+    RETIRE(SEQUENTIAL);
+
+SRLV:
+    tmp = RT;
+    tmp >>= RS & 0x1F;
+    RD = tmp;
+    RETIRE(SEQUENTIAL);
+
+SUB:
+    diff = RS - RT;
+    if ((RS ^ RT) & SIGN_BIT && (RS ^ diff) & SIGN_BIT) {
+        RaiseException(OVERFLOW_EXCEPTION, 0);
+        goto TICK;
+    }
+    RD = diff;
+    RETIRE(SEQUENTIAL);
+
+SUBU:
+    RD = RS - RT;
+    RETIRE(SEQUENTIAL);
+
+SW:
+    if (!WriteMem((unsigned) (RS + instr->extra), 4, RT)) {
+        goto TICK;
+    }
+    RETIRE(SEQUENTIAL);
+
+SWL:
+    tmp = RS + instr->extra;
+    ASSERT((tmp & 0x3) == 0);  // See `ExecInstruction`.
+    if (!ReadMem(tmp & ~0x3, 4, &value)) {
+        goto TICK;
+    }
+    switch (tmp & 0x3) {
+        case 0:
+            value = RT;
+            break;
+        case 1:
+            value = (value & 0xFF000000) | (RT >> 8 & 0xFFFFFF);
+            break;
+        case 2:
+            value = (value & 0xFFFF0000) | (RT >> 16 & 0xFFFF);
+            break;
+        case 3:
+            value = (value & 0xFFFFFF00) | (RT >> 24 & 0xFF);
+            break;
+    }
+    if (!WriteMem(tmp & ~0x3, 4, value)) {
+        goto TICK;
+    }
+    RETIRE(SEQUENTIAL);
+
+SWR:
+    tmp = RS + instr->extra;
+    ASSERT((tmp & 0x3) == 0);  // See `ExecInstruction`.
+    if (!ReadMem(tmp & ~0x3, 4, &value)) {
+        goto TICK;
+    }
+    switch (tmp & 0x3) {
+        case 0:
+            value = (value & 0xFFFFFF) | RT << 24;
+            break;
+        case 1:
+            value = (value & 0xFFFF) | RT << 16;
+            break;
+        case 2:
+            value = (value & 0xFF) | RT << 8;
+            break;
+        case 3:
+            value = RT;
+            break;
+    }
+    if (!WriteMem(tmp & ~0x3, 4, value)) {
+        goto TICK;
+    }
+    RETIRE(SEQUENTIAL);
+
+SYSCALL:
+    RaiseException(SYSCALL_EXCEPTION, 0);
+    goto TICK;
+
+XOR:
+    RD = RS ^ RT;
+    RETIRE(SEQUENTIAL);
+
+XORI:
+    RT = RS ^ (instr->extra & 0xFFFF);
+    RETIRE(SEQUENTIAL);
+
+ILLEGAL:
+    RaiseException(ILLEGAL_INSTR_EXCEPTION, 0);
+    goto TICK;
+
+BAD:
+    ASSERT(false);
+    goto TICK;
+
+#undef RS
+#undef RT
+#undef RD
+#undef BRANCH_TARGET
+#undef DISPATCH
+#undef ADVANCE
+#undef RETIRE
+#undef RETIRE_LOAD
+#undef SEQUENTIAL
+}
+
+#endif
@@ -10,7 +10,10 @@
 ///
 /// Translation lookaside buffer -- associative lookup in the table to find
 /// an entry with the same virtual page #.  If found, this entry is used for
-/// the translation.  If not, it traps to software with an exception.
+/// the translation.  If not, it traps to software with an exception.  Only
+/// the entries of one set are looked at, chosen by the low bits of the page
+/// number, and only those tagged with the identifier of the running address
+/// space (`MMU::asid`).
 ///
 /// In practice, the TLB is much smaller than the amount of physical memory
 /// (16 entries is common on a machine that has 1000's of pages).  Thus,
@@ -18,7 +21,8 @@
 /// the hardware does not need to know anything at all about that.
 ///
 /// Note that the contents of the TLB are specific to an address space.
-/// If the address space changes, so does the contents of the TLB!
+/// If the address space changes, so does the contents of the TLB, unless
+/// entries of different address spaces are told apart by their `asid`!
 ///
 /// DO NOT CHANGE -- part of the machine emulation
 ///
@@ -30,46 +34,198 @@
 
 #include "mmu.hh"
 #include "endianness.hh"
+#include "system_dep.hh"
 
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
 
 
-MMU::MMU()
+bool
+ParseTLBPolicy(const char *name, TLBPolicy *policy)
 {
-    mainMemory = new char [MEMORY_SIZE];
-    for (unsigned i = 0; i < MEMORY_SIZE; i++) {
-        mainMemory[i] = 0;
+    ASSERT(name != nullptr);
+    ASSERT(policy != nullptr);
+
+    if (strcmp(name, "random") == 0) {
+        *policy = TLB_RANDOM;
+    } else if (strcmp(name, "rr") == 0) {
+        *policy = TLB_ROUND_ROBIN;
+    } else if (strcmp(name, "lru") == 0) {
+        *policy = TLB_LRU;
+    } else {
+        return false;
     }
+    return true;
+}
 
-#ifdef USE_TLB
-    tlb = new TranslationEntry[TLB_SIZE];
-    for (unsigned i = 0; i < TLB_SIZE; i++) {
-        tlb[i].valid = false;
-    }
+MMU::MMU(unsigned numPhysPages_)
+{
+    ASSERT(numPhysPages_ > 0 && numPhysPages_ <= MAX_NUM_PHYS_PAGES);
+
+    numPhysPages = numPhysPages_;
+    memorySize   = numPhysPages * PAGE_SIZE;
+    // Anonymous pages of the host are zeroed when first touched, so memory
+    // costs nothing until used.
+    void *memory = mmap(nullptr, memorySize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT(memory != MAP_FAILED);
+    mainMemory  = (char *) memory;
+    decodeCache = new DecodeCache(mainMemory, numPhysPages, PAGE_SIZE);
+    owner       = true;
+
+    tlb       = nullptr;
+    tlbStamps = nullptr;
+    tlbNext   = nullptr;
     pageTable = nullptr;
-#else  // Use linear page table.
-    tlb = nullptr;
+    asid      = 0;
+#ifdef USE_TLB
+    SetUpTLB(TLB_SIZE, TLB_SIZE, TLB_ROUND_ROBIN);
+#endif  // Otherwise, use linear page table.
+    FlushHostCache();
+}
+
+MMU::MMU(MMU *boot)
+{
+    ASSERT(boot != nullptr);
+
+    numPhysPages = boot->numPhysPages;
+    memorySize   = boot->memorySize;
+    mainMemory   = boot->mainMemory;
+    decodeCache  = boot->decodeCache;
+    owner        = false;
+
+    tlb       = nullptr;
+    tlbStamps = nullptr;
+    tlbNext   = nullptr;
     pageTable = nullptr;
+    asid      = 0;
+#ifdef USE_TLB
+    SetUpTLB(boot->tlbSize, boot->tlbWays, boot->tlbPolicy);
 #endif
+    FlushHostCache();
 }
 
 MMU::~MMU()
 {
-    delete [] mainMemory;
-    if (tlb != nullptr) {
-        delete [] tlb;
+    if (owner) {
+        delete decodeCache;
+        munmap(mainMemory, memorySize);
     }
+    delete [] tlb;
+    delete [] tlbStamps;
+    delete [] tlbNext;
+}
+
+void
+MMU::SetUpTLB(unsigned size, unsigned ways, TLBPolicy policy)
+{
+#ifdef USE_TLB
+    ASSERT(size > 0 && size <= MAX_TLB_SIZE && (size & (size - 1)) == 0);
+    ASSERT(ways > 1 && ways <= size && (ways & (ways - 1)) == 0);
+
+    delete [] tlb;
+    delete [] tlbStamps;
+    delete [] tlbNext;
+    tlbSize   = size;
+    tlbWays   = ways;
+    tlbPolicy = policy;
+    tlb       = new TranslationEntry[size];
+    tlbStamps = new unsigned long [size];
+    tlbNext   = new unsigned [size / ways];
+    for (unsigned i = 0; i < size; i++) {
+        tlb[i].valid = false;
+        tlbStamps[i] = 0;
+    }
+    for (unsigned i = 0; i < size / ways; i++) {
+        tlbNext[i] = 0;
+    }
+    tlbClock = 0;
+    FlushHostCache();
+#endif
+}
+
+unsigned
+MMU::GetTLBSize() const
+{
+    return tlb == nullptr ? 0 : tlbSize;
+}
+
+TranslationEntry *
+MMU::FindTLBEntry(unsigned vpn, unsigned asid_) const
+{
+    ASSERT(tlb != nullptr);
+
+    TranslationEntry *set = TLBSet(vpn);
+    for (unsigned i = 0; i < tlbWays; i++) {
+        if (set[i].valid && set[i].virtualPage == vpn
+              && set[i].asid == asid_) {
+            return &set[i];
+        }
+    }
+    return nullptr;
+}
+
+void
+MMU::FlushTLB(unsigned asid_)
+{
+    ASSERT(tlb != nullptr);
+
+    for (unsigned i = 0; i < tlbSize; i++) {
+        if (tlb[i].asid == asid_) {
+            tlb[i].valid = false;
+        }
+    }
+    FlushHostCache();
+}
+
+TranslationEntry *
+MMU::PickTLBEntry(unsigned vpn)
+{
+    ASSERT(tlb != nullptr);
+
+    TranslationEntry *set = TLBSet(vpn);
+    unsigned way = 0;
+    while (way < tlbWays && set[way].valid) {
+        way++;
+    }
+    if (way == tlbWays) {
+        unsigned first = set - tlb;
+        switch (tlbPolicy) {
+            case TLB_RANDOM:
+                way = SystemDep::Random() % tlbWays;
+                break;
+
+            case TLB_ROUND_ROBIN:
+                way = tlbNext[first / tlbWays];
+                tlbNext[first / tlbWays] = (way + 1) % tlbWays;
+                break;
+
+            case TLB_LRU:
+                way = 0;
+                for (unsigned i = 1; i < tlbWays; i++) {
+                    if (tlbStamps[first + i] < tlbStamps[first + way]) {
+                        way = i;
+                    }
+                }
+                break;
+        }
+    }
+    // It is about to be used.
+    tlbStamps[&set[way] - tlb] = ++tlbClock;
+    return &set[way];
 }
 
 void
 MMU::PrintTLB() const
 {
 #ifdef USE_TLB
-    printf("TLB content (%u entries):\n", TLB_SIZE);
-    for (unsigned i = 0; i < TLB_SIZE; i++) {
+    printf("TLB content (%u entries, %u-way):\n", tlbSize, tlbWays);
+    for (unsigned i = 0; i < tlbSize; i++) {
         const TranslationEntry *e = &tlb[i];
-        printf("(%u) valid: %d, virt: %d, frame: %d, flags: %s%s%s\n",
-               i, e->valid, e->virtualPage, e->physicalPage,
+        printf("(%u) valid: %d, asid: %u, virt: %d, frame: %d,"
+               " flags: %s%s%s\n",
+               i, e->valid, e->asid, e->virtualPage, e->physicalPage,
                (e->readOnly) ? "readonly " : "",
                (e->use)      ? "use " : "",
                (e->dirty)    ? "dirty" : "");
@@ -95,26 +251,30 @@ MMU::ReadMem(unsigned addr, unsigned size, int *value)
 
     DEBUG('a', "Reading VA 0x%X, size %u\n", addr, size);
 
-    unsigned physicalAddress;
-    ExceptionType e = Translate(addr, &physicalAddress, size, false);
-    if (e != NO_EXCEPTION) {
-        return e;
+    const char *host = FindHost(addr, size, false);
+    if (host == nullptr) {
+        unsigned physicalAddress;
+        ExceptionType e = Translate(addr, &physicalAddress, size, false);
+        if (e != NO_EXCEPTION) {
+            return e;
+        }
+        host = &mainMemory[physicalAddress];
     }
 
     int data;
     switch (size) {
         case 1:
-            data = mainMemory[physicalAddress];
+            data = *host;
             *value = data;
             break;
 
         case 2:
-            data = *(unsigned short *) &mainMemory[physicalAddress];
+            data = *(const unsigned short *) host;
             *value = ShortToHost(data);
             break;
 
         case 4:
-            data = *(unsigned *) &mainMemory[physicalAddress];
+            data = *(const unsigned *) host;
             *value = WordToHost(data);
             break;
 
@@ -140,35 +300,126 @@ MMU::WriteMem(unsigned addr, unsigned size, int value)
 {
     DEBUG('a', "Writing VA 0x%X, size %u, value 0x%X\n", addr, size, value);
 
-    unsigned physicalAddress;
-    ExceptionType e = Translate(addr, &physicalAddress, size, true);
-    if (e != NO_EXCEPTION) {
-        return e;
+    char *host = FindHost(addr, size, true);
+    if (host == nullptr) {
+        unsigned physicalAddress;
+        ExceptionType e = Translate(addr, &physicalAddress, size, true);
+        if (e != NO_EXCEPTION) {
+            return e;
+        }
+        host = &mainMemory[physicalAddress];
     }
 
     switch (size) {
         case 1:
-            mainMemory[physicalAddress]
-              = (unsigned char) (value & 0xFF);
+            *host = (unsigned char) (value & 0xFF);
             break;
 
         case 2:
-            *(unsigned short *) &mainMemory[physicalAddress]
+            *(unsigned short *) host
               = ShortToMachine((unsigned short) (value & 0xFFFF));
             break;
 
         case 4:
-            *(unsigned *) &mainMemory[physicalAddress]
-              = WordToMachine((unsigned) value);
+            *(unsigned *) host = WordToMachine((unsigned) value);
             break;
 
         default:
             ASSERT(false);
     }
+    decodeCache->Write(host - mainMemory);
+
+    return NO_EXCEPTION;
+}
+
+ExceptionType
+MMU::TranslateToHost(unsigned addr, bool writing, char **host)
+{
+    ASSERT(host != nullptr);
+
+    DEBUG('a', "Translating VA 0x%X for the kernel\n", addr);
 
+    *host = FindHost(addr, 1, writing);
+    if (*host == nullptr) {
+        unsigned physicalAddress;
+        ExceptionType e = Translate(addr, &physicalAddress, 1, writing);
+        if (e != NO_EXCEPTION) {
+            return e;
+        }
+        *host = &mainMemory[physicalAddress];
+    }
     return NO_EXCEPTION;
 }
 
+/// Fetch the instruction at virtual address `addr`, in decoded form.
+///
+/// Returns the exception raised by the translation, if any.
+///
+/// * `addr` is the virtual address to fetch from.
+/// * `instr` is the place to store a pointer to the decoded instruction; it
+///   stays valid until the next write to memory.
+/// * `physAddr`, if not null, is the place to store the physical address
+///   of the instruction.
+ExceptionType
+MMU::ReadInstruction(unsigned addr, const Instruction **instr,
+                     unsigned *physAddr)
+{
+    ASSERT(instr != nullptr);
+
+    DEBUG('a', "Fetching VA 0x%X\n", addr);
+
+    unsigned physicalAddress;
+    const char *host = FindHost(addr, 4, false);
+    if (host != nullptr) {
+        physicalAddress = host - mainMemory;
+    } else {
+        ExceptionType e = Translate(addr, &physicalAddress, 4, false);
+        if (e != NO_EXCEPTION) {
+            return e;
+        }
+    }
+
+    *instr = decodeCache->Lookup(physicalAddress);
+    if (physAddr != nullptr) {
+        *physAddr = physicalAddress;
+    }
+    return NO_EXCEPTION;
+}
+
+void
+MMU::InvalidateFrame(unsigned frame)
+{
+    ASSERT(frame < numPhysPages);
+    decodeCache->Invalidate(frame);
+}
+
+DecodeCache *
+MMU::GetDecodeCache()
+{
+    return decodeCache;
+}
+
+unsigned
+MMU::GetNumPhysPages() const
+{
+    return numPhysPages;
+}
+
+unsigned
+MMU::GetMemorySize() const
+{
+    return memorySize;
+}
+
+void
+MMU::FlushHostCache()
+{
+    for (unsigned i = 0; i < HOST_CACHE_SIZE; i++) {
+        hostCache[i].virtualPage = (unsigned) -1;
+    }
+    hostCachePageTable = pageTable;
+}
+
 ExceptionType
 MMU::RetrievePageEntry(unsigned vpn, TranslationEntry **entry) const
 {
@@ -194,16 +445,16 @@ MMU::RetrievePageEntry(unsigned vpn, TranslationEntry **entry) const
     } else {
         // Use the TLB.
 
-        unsigned i;
-        for (i = 0; i < TLB_SIZE; i++) {
-            TranslationEntry *e = &tlb[i];
-            if (e->valid && e->virtualPage == vpn) {
-                *entry = e;  // FOUND!
-                return NO_EXCEPTION;
-            }
+        TranslationEntry *e = FindTLBEntry(vpn, asid);
+        if (e != nullptr) {
+            *entry = e;  // FOUND!
+            stats->numTLBHits++;
+            tlbStamps[e - tlb] = ++tlbClock;
+            return NO_EXCEPTION;
         }
 
         // Not found.
+        stats->numTLBMisses++;
         DEBUG_CONT('a', "no valid TLB entry found for this virtual page!\n");
         return PAGE_FAULT_EXCEPTION;  // Really, this is a TLB fault, the
                                       // page may be in memory, but not in
@@ -261,8 +512,8 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr,
 
     // If the `pageFrame` is too big, there is something really wrong!  An
     // invalid translation was loaded into the page table or TLB.
-    if (pageFrame >= NUM_PHYS_PAGES) {
-        DEBUG_CONT('a', "frame %u > %u!\n", pageFrame, NUM_PHYS_PAGES);
+    if (pageFrame >= numPhysPages) {
+        DEBUG_CONT('a', "frame %u > %u!\n", pageFrame, numPhysPages);
         return BUS_ERROR_EXCEPTION;
     }
 
@@ -273,7 +524,19 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr,
     }
 
     *physAddr = pageFrame * PAGE_SIZE + offset;
-    ASSERT(*physAddr >= 0 && *physAddr + size <= MEMORY_SIZE);
+    ASSERT(*physAddr >= 0 && *physAddr + size <= memorySize);
+
+    // Remember the translation, so that `FindHost` can skip all of the
+    // above next time.
+    if (pageTable != hostCachePageTable) {
+        FlushHostCache();
+    }
+    HostPage *page = &hostCache[vpn % HOST_CACHE_SIZE];
+    page->virtualPage = vpn;
+    page->entry       = entry;
+    page->base        = &mainMemory[pageFrame * PAGE_SIZE];
+    page->writable    = !entry->readOnly;
+
     DEBUG_CONT('a', "physical address 0x%X\n", *physAddr);
     return NO_EXCEPTION;
 }
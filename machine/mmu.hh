@@ -10,7 +10,9 @@
 
 
 #include "exception_type.hh"
+#include "decode_cache.hh"
 #include "disk.hh"
+#include "statistics.hh"
 #include "translation_entry.hh"
 
 
@@ -19,21 +21,56 @@
 const unsigned PAGE_SIZE = SECTOR_SIZE;  ///< Set the page size equal to the
                                          ///< disk sector size, for
                                          ///< simplicity.
-const unsigned NUM_PHYS_PAGES = 128;
-const unsigned MEMORY_SIZE = NUM_PHYS_PAGES * PAGE_SIZE;
 
-/// Number of entries in the TLB, if one is present.
+/// Default number of frames of physical memory.
 ///
-/// If there is a TLB, it will be small compared to page tables.
+/// It can be changed at startup, up to `MAX_NUM_PHYS_PAGES` (see
+/// `MMU::MMU`); frames never touched cost no host memory.
+const unsigned DEFAULT_NUM_PHYS_PAGES = 128;
+const unsigned MAX_NUM_PHYS_PAGES = 1 << 20;
+
+/// Default number of entries in the TLB, if one is present.
+///
+/// If there is a TLB, it will be small compared to page tables.  Its size
+/// can be changed at startup, up to `MAX_TLB_SIZE` (see `MMU::SetUpTLB`).
 const unsigned TLB_SIZE = 4;
+const unsigned MAX_TLB_SIZE = 512;
+
+/// Number of address space identifiers that TLB entries can be tagged with.
+const unsigned NUM_ASIDS = 64;
+
+/// Ways of choosing the TLB entry to replace, among those of a set.
+enum TLBPolicy {
+    TLB_RANDOM,
+    TLB_ROUND_ROBIN,
+    TLB_LRU
+};
+
+/// Set `policy` from its name: `random`, `rr` or `lru`.
+///
+/// Returns false if the name is not known.
+bool ParseTLBPolicy(const char *name, TLBPolicy *policy);
+
+/// Performance metrics, defined in `threads/system.cc`.
+extern Statistics *stats;
+
+/// Number of entries in the cache of host addresses kept by the MMU (see
+/// `MMU::FindHost`).
+const unsigned HOST_CACHE_SIZE = 32;
 
 
 /// This class simulates an MMU (memory management unit) that can use either
 /// page tables or a TLB.
 class MMU {
 public:
-    // Initialize the MMU subsystem.
-    MMU();
+    // Initialize the MMU subsystem, with `numPhysPages` frames of physical
+    // memory, every one zeroed.
+    MMU(unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES);
+
+    // Initialize the MMU of another processor, sharing the physical memory
+    // and the decode cache of `boot`, with a TLB and a cache of host
+    // addresses of its own.
+    MMU(MMU *boot);
 
     // Deallocate data structures.
     ~MMU();
@@ -45,8 +82,73 @@ public:
 
     ExceptionType WriteMem(unsigned addr, unsigned size, int value);
 
+    /// Fetch the already decoded instruction at virtual address `addr`.
+    ///
+    /// Translation happens exactly as for a 4-byte `ReadMem`.
+    ExceptionType ReadInstruction(unsigned addr, const Instruction **instr,
+                                  unsigned *physAddr = nullptr);
+
+    /// Translate virtual address `addr` into where it lives in
+    /// `mainMemory`, for the kernel to copy whole runs of the page at once;
+    /// the rest of the page follows it there.
+    ///
+    /// The page is checked and marked as by a one-byte access, writing if
+    /// `writing`.  A kernel writing through `host` must then call
+    /// `InvalidateFrame`.  Returns the exception raised by the translation,
+    /// if any.
+    ExceptionType TranslateToHost(unsigned addr, bool writing, char **host);
+
+    /// Tell the MMU that the contents of physical frame `frame` were changed
+    /// behind its back (by writing `mainMemory` directly), or that the frame
+    /// is being given to another page.
+    void InvalidateFrame(unsigned frame);
+
+    DecodeCache *GetDecodeCache();
+
+    unsigned GetNumPhysPages() const;
+
+    /// Return the size of `mainMemory`, in bytes.
+    unsigned GetMemorySize() const;
+
+    /// Forget every cached translation to a host address.
+    ///
+    /// The MMU notices by itself when `pageTable` points somewhere else, but
+    /// the kernel must call this whenever it changes an entry of the page
+    /// table in use (other than its `use` and `dirty` bits) or of the TLB.
+    void FlushHostCache();
+
     void PrintTLB() const;
 
+    /// Organize the TLB, if there is one, as `size` entries in sets of
+    /// `ways` entries, replaced following `policy`; every entry is left
+    /// invalid.
+    ///
+    /// Both numbers must be powers of two, with `ways` at most `size`.
+    /// The TLB is fully associative if `ways` equals `size`.  By default,
+    /// it is fully associative, with `TLB_SIZE` entries replaced in turn.
+    ///
+    /// There must be at least two ways: an instruction may need the
+    /// translations of two pages at once, its own and the one it loads or
+    /// stores, and in a direct-mapped TLB both could compete for the same
+    /// entry forever.
+    void SetUpTLB(unsigned size, unsigned ways, TLBPolicy policy);
+
+    unsigned GetTLBSize() const;
+
+    /// Return the valid TLB entry for page `vpn` of address space `asid`,
+    /// or null if there is none.
+    TranslationEntry *FindTLBEntry(unsigned vpn, unsigned asid) const;
+
+    /// Invalidate every TLB entry of address space `asid`.
+    void FlushTLB(unsigned asid);
+
+    /// Return the TLB entry that should hold the translation of page
+    /// `vpn`, after a miss: an invalid entry of the set of the page, if
+    /// any, or else the one chosen by the replacement policy.
+    ///
+    /// The translation is only found if the kernel puts it there.
+    TranslationEntry *PickTLBEntry(unsigned vpn);
+
     /// Data structures -- all of these are accessible to Nachos kernel code.
     /// “Public” for convenience.
     ///
@@ -66,7 +168,9 @@ public:
     ///
     /// If `tlb` is null, the linear page table is used.
     /// If `tlb` is non-null, the Nachos kernel is responsible for managing
-    /// the contents of the TLB.  But the kernel can use any data structure
+    /// the contents of the TLB.  A page may only be found in the entries of
+    /// its set, so the kernel must load translations where `PickTLBEntry`
+    /// says.  But the kernel can use any data structure
     /// it wants (eg, segmented paging) for handling TLB cache misses.
     ///
     /// For simplicity, both the page table pointer and the TLB pointer are
@@ -79,6 +183,11 @@ public:
     TranslationEntry *tlb;  ///< This pointer should be considered
                             ///< “read-only” to Nachos kernel code.
 
+    /// Identifier of the running address space: TLB entries tagged with
+    /// any other are ignored, so they need not be invalidated on a context
+    /// switch.  The kernel must call `FlushHostCache` after changing it.
+    unsigned asid;
+
     TranslationEntry *pageTable;
     unsigned pageTableSize;
 
@@ -95,6 +204,78 @@ private:
     /// completed.
     ExceptionType Translate(unsigned virtAddr, unsigned *physAddr,
                             unsigned size, bool writing);
+
+    /// Return where the `size` bytes at virtual address `addr` are in
+    /// `mainMemory`, if a previous translation of the same page can be
+    /// reused; otherwise return null, and `Translate` must be used.
+    ///
+    /// The `use` and `dirty` bits of the entry are set as `Translate`
+    /// would.
+    char *FindHost(unsigned addr, unsigned size, bool writing)
+    {
+        if (addr & (size - 1) || pageTable != hostCachePageTable) {
+            return nullptr;
+        }
+        unsigned vpn = addr / PAGE_SIZE;
+        HostPage *page = &hostCache[vpn % HOST_CACHE_SIZE];
+        if (page->virtualPage != vpn || (writing && !page->writable)) {
+            return nullptr;
+        }
+        page->entry->use = true;
+        if (writing) {
+            page->entry->dirty = true;
+        }
+#ifdef USE_TLB
+        // Only translations in the TLB are cached, so this is a hit.
+        stats->numTLBHits++;
+        tlbStamps[page->entry - tlb] = ++tlbClock;
+#endif
+        return page->base + addr % PAGE_SIZE;
+    }
+
+    /// Return the first entry of the TLB set of page `vpn`.
+    TranslationEntry *TLBSet(unsigned vpn) const
+    {
+        return &tlb[(vpn & (tlbSize / tlbWays - 1)) * tlbWays];
+    }
+
+    /// A virtual page translated by `Translate`, and where it lives in
+    /// `mainMemory`.
+    struct HostPage {
+        unsigned virtualPage;     ///< Invalid if greater than any page.
+        TranslationEntry *entry;
+        char *base;
+        bool writable;
+    };
+
+    /// Direct-mapped cache of translated pages, indexed by virtual page
+    /// number.
+    HostPage hostCache[HOST_CACHE_SIZE];
+
+    /// Page table the contents of `hostCache` come from.
+    const TranslationEntry *hostCachePageTable;
+
+    /// Decoded form of the frames user code is executed from.
+    DecodeCache *decodeCache;
+
+    /// Whether this MMU allocated `mainMemory` and `decodeCache`, rather
+    /// than sharing those of another processor.
+    bool owner;
+
+    unsigned numPhysPages;
+    unsigned memorySize;
+
+    /// Organization of the TLB.
+    unsigned tlbSize;
+    unsigned tlbWays;
+    TLBPolicy tlbPolicy;
+
+    /// When every TLB entry was last used, for `TLB_LRU`.
+    mutable unsigned long *tlbStamps;
+    mutable unsigned long tlbClock;
+
+    /// Next entry to replace within every set, for `TLB_ROUND_ROBIN`.
+    unsigned *tlbNext;
 };
 
 
@@ -0,0 +1,165 @@
+/// Routines to count and report the execution of a user program.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "profile.hh"
+#include "lib/utility.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+Profile::Profile(unsigned size_, unsigned numSymbols_)
+{
+    size = size_;
+    instructions = new unsigned long [size / 4];
+    accesses     = new unsigned long [size / 4];
+    for (unsigned i = 0; i < size / 4; i++) {
+        instructions[i] = 0;
+        accesses[i]     = 0;
+    }
+    for (unsigned i = 0; i < NUM_EXCEPTION_TYPES; i++) {
+        exceptions[i] = 0;
+    }
+
+    numSymbols      = numSymbols_;
+    symbolAddresses = new unsigned [numSymbols];
+    symbolNames     = new char * [numSymbols];
+    for (unsigned i = 0; i < numSymbols; i++) {
+        symbolAddresses[i] = 0;
+        symbolNames[i]     = nullptr;
+    }
+}
+
+Profile::Profile(const Profile *parent)
+    : Profile(parent->size, parent->numSymbols)
+{
+    for (unsigned i = 0; i < numSymbols; i++) {
+        SetSymbol(i, parent->symbolAddresses[i], parent->symbolNames[i]);
+    }
+}
+
+Profile::~Profile()
+{
+    for (unsigned i = 0; i < numSymbols; i++) {
+        delete [] symbolNames[i];
+    }
+    delete [] symbolNames;
+    delete [] symbolAddresses;
+    delete [] instructions;
+    delete [] accesses;
+}
+
+void
+Profile::SetSymbol(unsigned i, unsigned address, const char *name)
+{
+    ASSERT(i < numSymbols);
+    ASSERT(name != nullptr);
+    ASSERT(i == 0 || symbolAddresses[i - 1] <= address);
+
+    symbolAddresses[i] = address;
+    delete [] symbolNames[i];
+    symbolNames[i] = new char [strlen(name) + 1];
+    strcpy(symbolNames[i], name);
+}
+
+/// Counts attributed to a procedure, or to a single instruction if there
+/// are no symbols.
+struct ProfileLine {
+    const char *name;  ///< Null if the line is for a single instruction.
+    unsigned address;
+    unsigned long instructions;
+    unsigned long accesses;
+};
+
+static int
+CompareLines(const void *a, const void *b)
+{
+    const ProfileLine *x = (const ProfileLine *) a;
+    const ProfileLine *y = (const ProfileLine *) b;
+    if (x->instructions != y->instructions) {
+        return x->instructions > y->instructions ? -1 : 1;
+    }
+    if (x->accesses != y->accesses) {
+        return x->accesses > y->accesses ? -1 : 1;
+    }
+    return x->address < y->address ? -1 : x->address > y->address;
+}
+
+void
+Profile::Print(const char *name) const
+{
+    ASSERT(name != nullptr);
+
+    // One line per procedure, plus one for code before the first of them;
+    // or one per instruction if there are no symbols.
+    unsigned numLines = numSymbols != 0 ? numSymbols + 1 : size / 4;
+    ProfileLine *lines = new ProfileLine [numLines];
+    for (unsigned i = 0; i < numLines; i++) {
+        lines[i].name         = nullptr;
+        lines[i].address      = numSymbols != 0 ? 0 : i * 4;
+        lines[i].instructions = 0;
+        lines[i].accesses     = 0;
+    }
+    for (unsigned i = 0; i < numSymbols; i++) {
+        lines[i + 1].name    = symbolNames[i];
+        lines[i + 1].address = symbolAddresses[i];
+    }
+
+    unsigned long totalInstructions = 0, totalAccesses = 0;
+    unsigned line = 0;
+    for (unsigned i = 0; i < size / 4; i++) {
+        if (numSymbols == 0) {
+            line = i;
+        } else {
+            // Words are visited in order, so just move past the procedures
+            // starting at or before this word.
+            while (line < numSymbols && symbolAddresses[line] <= i * 4) {
+                line++;
+            }
+        }
+        lines[line].instructions += instructions[i];
+        lines[line].accesses     += accesses[i];
+        totalInstructions += instructions[i];
+        totalAccesses     += accesses[i];
+    }
+
+    printf("Profile of %s: %lu instructions, %lu memory accesses\n",
+           name, totalInstructions, totalAccesses);
+    printf("Exceptions:");
+    bool any = false;
+    for (unsigned i = 0; i < NUM_EXCEPTION_TYPES; i++) {
+        if (exceptions[i] != 0) {
+            printf(" %s %lu", ExceptionTypeToString((ExceptionType) i),
+                   exceptions[i]);
+            any = true;
+        }
+    }
+    printf(any ? "\n" : " none\n");
+
+    qsort(lines, numLines, sizeof *lines, CompareLines);
+    printf("%14s %7s %12s  %s\n",
+           "instructions", "%", "accesses", "procedure");
+    for (unsigned i = 0; i < numLines && i < PROFILE_REPORT_LINES; i++) {
+        const ProfileLine *l = &lines[i];
+        if (l->instructions == 0 && l->accesses == 0) {
+            break;
+        }
+        printf("%14lu %6.2f%% %12lu  ", l->instructions,
+               100.0 * l->instructions / totalInstructions, l->accesses);
+        if (l->name != nullptr) {
+            printf("%s\n", l->name);
+        } else if (numSymbols != 0) {
+            printf("(before first symbol)\n");
+        } else {
+            printf("0x%X\n", l->address);
+        }
+    }
+    printf("\n");
+
+    delete [] lines;
+}
@@ -0,0 +1,86 @@
+/// Execution profile of a user program.
+///
+/// When user programs are profiled, the machine counts, for every
+/// instruction of the running address space, how many times it was executed
+/// and how many memory accesses it did, and it counts the exceptions
+/// raised.  The counts are exact: all the instructions are interpreted, one
+/// by one, while profiling.
+///
+/// The report attributes the counts to the procedures of the program,
+/// using the symbol table that `coff2noff` copies into the executable.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_PROFILE__HH
+#define NACHOS_MACHINE_PROFILE__HH
+
+
+#include "exception_type.hh"
+
+
+/// Number of procedures shown by `Profile::Print`.
+const unsigned PROFILE_REPORT_LINES = 10;
+
+class Profile {
+public:
+
+    /// Prepare to profile an address space of `size` bytes, whose code has
+    /// `numSymbols` procedures (see `SetSymbol`).
+    Profile(unsigned size, unsigned numSymbols);
+
+    /// Prepare to profile a copy of the address space profiled by `parent`,
+    /// with the same procedures; counts start at zero.
+    Profile(const Profile *parent);
+
+    ~Profile();
+
+    /// Name procedure number `i`, which starts at `address`.
+    ///
+    /// Procedures must be numbered in order of increasing address.
+    void SetSymbol(unsigned i, unsigned address, const char *name);
+
+    /// Count one execution of the instruction at `pc`.
+    void CountInstruction(unsigned pc)
+    {
+        if (pc < size) {
+            instructions[pc / 4]++;
+        }
+    }
+
+    /// Count a memory access by the instruction at `pc`.
+    void CountAccess(unsigned pc)
+    {
+        if (pc < size) {
+            accesses[pc / 4]++;
+        }
+    }
+
+    void CountException(ExceptionType et)
+    {
+        exceptions[et]++;
+    }
+
+    /// Print the totals and the hottest procedures of the program `name`.
+    void Print(const char *name) const;
+
+private:
+
+    /// Size of the address space.
+    unsigned size;
+
+    /// Counts, indexed by word in the address space.
+    unsigned long *instructions;
+    unsigned long *accesses;
+
+    unsigned long exceptions[NUM_EXCEPTION_TYPES];
+
+    /// Procedures, sorted by address.
+    unsigned numSymbols;
+    unsigned *symbolAddresses;
+    char **symbolNames;
+};
+
+
+#endif
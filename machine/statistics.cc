@@ -21,6 +21,9 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPagesReadAhead = numPageWrites = pagingTicks = 0;
+    numTLBHits = numTLBMisses = 0;
+    numSyscalls = 0;
 #ifdef DFS_TICKS_FIX
     tickResets = 0;
 #endif
@@ -43,7 +46,12 @@ Statistics::Print()
     printf("Disk I/O: reads %lu, writes %lu\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %lu, writes %lu\n",
            numConsoleCharsRead, numConsoleCharsWritten);
-    printf("Paging: faults %lu\n", numPageFaults);
+    printf("Paging: faults %lu, read ahead %lu, writes %lu, disk ticks %lu\n",
+           numPageFaults, numPagesReadAhead, numPageWrites, pagingTicks);
+#ifdef USE_TLB
+    printf("TLB: hits %lu, misses %lu\n", numTLBHits, numTLBMisses);
+#endif
+    printf("System calls: %lu\n", numSyscalls);
     printf("Network I/O: packets received %lu, sent %lu\n",
            numPacketsRecvd, numPacketsSent);
 }
@@ -47,6 +47,25 @@ public:
     /// Number of virtual memory page faults.
     unsigned long numPageFaults;
 
+    /// Number of pages loaded ahead of a fault, along with the faulting
+    /// page.
+    unsigned long numPagesReadAhead;
+
+    /// Number of modified pages written back to swap.
+    unsigned long numPageWrites;
+
+    /// Time the disk spent transferring pages to and from swap.  Transfers
+    /// of other threads meanwhile are not counted, so, unlike the time
+    /// elapsed, it does not count the same ticks twice.
+    unsigned long pagingTicks;
+
+    /// Number of translations found in the TLB, and not found.
+    unsigned long numTLBHits;
+    unsigned long numTLBMisses;
+
+    /// Number of system calls made by user programs.
+    unsigned long numSyscalls;
+
     /// Number of packets sent over the network.
     unsigned long numPacketsSent;
 
@@ -54,6 +54,10 @@ public:
     /// This bit is set by the hardware every time the page is modified.
     bool dirty;
 
+    /// Identifier of the address space the translation belongs to.  Only
+    /// looked at in the TLB, where it must match `MMU::asid`.
+    unsigned asid;
+
 };
 
 
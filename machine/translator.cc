@@ -0,0 +1,1055 @@
+/// Translation of MIPS basic blocks into x86-64 code.
+///
+/// Translated code keeps a pointer to `registers` in `rbx`, the context in
+/// `r12` and the virtual address of the first instruction of the block in
+/// `r13`, and works on the registers in memory, so that they are always up
+/// to date when a helper is called.  Program counters are only written
+/// before calling a helper and when leaving the block.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 1992-1993 The Regents of the University of California.
+///               2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef MIPS_JIT
+
+#ifndef __x86_64__
+#error "MIPS_JIT translates to x86-64 code only."
+#endif
+
+#include "translator.hh"
+#include "encoding.hh"
+#include "machine.hh"
+#include "threads/system.hh"
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+
+
+/// Size of the buffer for host code.
+static const unsigned CODE_SIZE = 16 * 1024 * 1024;
+
+/// Room that translating one block may need in the buffer.
+static const unsigned MAX_BLOCK_CODE = 16 * 1024;
+
+/// Number of times an instruction is reached before its block is
+/// translated.
+static const unsigned HOT_THRESHOLD = 16;
+
+/// Maximum number of instructions in a block.
+static const unsigned MAX_BLOCK_LENGTH = 64;
+
+/// Marks instructions that do not start a translatable block.
+static TranslatedBlock untranslatable = { 0, nullptr };
+
+/// Value returned by `TranslatedLoad` on exceptions; never a 32-bit value.
+static const int64_t LOAD_FAULT = (int64_t) 1 << 32;
+
+/// Results of `TranslatedStore`.
+enum {
+    STORE_FAULT = 0,
+    STORE_DONE = 1,
+    STORE_CODE_CHANGED = 2  ///< The store changed the running block.
+};
+
+
+/// Account for the first `done` instructions of the running block.
+static void
+Commit(TranslationContext *context, unsigned done)
+{
+    context->machine->CountTicks(done - context->committed);
+    context->committed = done;
+}
+
+/// Helpers called from translated code.  They do what `ExecInstruction`
+/// does for the same instructions.
+
+static int64_t
+TranslatedLoad(TranslationContext *context, unsigned addr,
+               unsigned opCode, unsigned done)
+{
+    MMU *mmu = context->machine->GetMMU();
+    ExceptionType e;
+    int value;
+
+    switch (opCode) {
+        case OP_LB:
+        case OP_LBU:
+            e = mmu->ReadMem(addr, 1, &value);
+            break;
+
+        case OP_LH:
+        case OP_LHU:
+            e = addr & 0x1 ? ADDRESS_ERROR_EXCEPTION
+                           : mmu->ReadMem(addr, 2, &value);
+            break;
+
+        default:  // `OP_LW`.
+            e = addr & 0x3 ? ADDRESS_ERROR_EXCEPTION
+                           : mmu->ReadMem(addr, 4, &value);
+            break;
+    }
+    if (e != NO_EXCEPTION) {
+        Commit(context, done);
+        context->exception = e;
+        context->badAddr   = addr;
+        return LOAD_FAULT;
+    }
+
+    switch (opCode) {
+        case OP_LB:
+            value = value & 0x80 ? value | 0xFFFFFF00 : value & 0xFF;
+            break;
+        case OP_LBU:
+            value &= 0xFF;
+            break;
+        case OP_LH:
+            value = value & 0x8000 ? value | 0xFFFF0000 : value & 0xFFFF;
+            break;
+        case OP_LHU:
+            value &= 0xFFFF;
+            break;
+    }
+    return (uint32_t) value;
+}
+
+static int
+TranslatedStore(TranslationContext *context, unsigned addr, int value,
+                unsigned size, unsigned done)
+{
+    ExceptionType e = context->machine->GetMMU()->WriteMem(addr, size,
+                                                           value);
+    if (e != NO_EXCEPTION) {
+        Commit(context, done);
+        context->exception = e;
+        context->badAddr   = addr;
+        return STORE_FAULT;
+    }
+    if (context->cache->Generation(context->frame) != context->generation) {
+        return STORE_CODE_CHANGED;
+    }
+    return STORE_DONE;
+}
+
+static void
+TranslatedDivide(int *registers, unsigned rs, unsigned rt, bool isSigned)
+{
+    if (isSigned) {
+        if (registers[rt] == 0) {
+            registers[LO_REG] = 0;
+            registers[HI_REG] = 0;
+        } else {
+            registers[LO_REG] = registers[rs] / registers[rt];
+            registers[HI_REG] = registers[rs] % registers[rt];
+        }
+    } else {
+        unsigned a = (unsigned) registers[rs];
+        unsigned b = (unsigned) registers[rt];
+        if (b == 0) {
+            registers[LO_REG] = 0;
+            registers[HI_REG] = 0;
+        } else {
+            registers[LO_REG] = (int) (a / b);
+            registers[HI_REG] = (int) (a % b);
+        }
+    }
+}
+
+
+/// Host registers, by their number in instruction encodings.
+enum {
+    EAX = 0,
+    ECX = 1,
+    EDX = 2,
+    EBX = 3,
+    R13 = 5,  ///< With a REX prefix.
+    ESI = 6,
+    EDI = 7
+};
+
+/// Condition codes.
+enum {
+    CC_B  = 0x2,
+    CC_E  = 0x4,
+    CC_NE = 0x5,
+    CC_L  = 0xC,
+    CC_GE = 0xD,
+    CC_LE = 0xE,
+    CC_G  = 0xF
+};
+
+/// Group 1 arithmetic, as the opcode of `op r32, r/m32` and as the `/digit`
+/// of `op r/m32, imm32`.
+enum {
+    ALU_ADD = 0,
+    ALU_OR  = 1,
+    ALU_AND = 4,
+    ALU_SUB = 5,
+    ALU_XOR = 6,
+    ALU_CMP = 7
+};
+
+/// Shifts, as the `/digit` of their encodings.
+enum {
+    SHIFT_LEFT  = 4,
+    SHIFT_RIGHT = 5,
+    SHIFT_ARITH = 7
+};
+
+/// Writes x86-64 instructions into a buffer.
+class Emitter {
+public:
+    Emitter(char *start)
+    {
+        position = (unsigned char *) start;
+    }
+
+    char *Position() const
+    {
+        return (char *) position;
+    }
+
+    void Byte(unsigned b)
+    {
+        *position++ = (unsigned char) b;
+    }
+
+    void Word(unsigned w)
+    {
+        memcpy(position, &w, 4);
+        position += 4;
+    }
+
+    /// Emit `opCode` with a register operand `reg` and a memory operand
+    /// for machine register `num`.
+    void RegisterOperand(unsigned opCode, unsigned reg, unsigned num)
+    {
+        unsigned disp = num * 4;
+        Byte(opCode);
+        if (disp < 128) {
+            Byte(0x40 | reg << 3 | EBX);
+            Byte(disp);
+        } else {
+            Byte(0x80 | reg << 3 | EBX);
+            Word(disp);
+        }
+    }
+
+    /// `mov reg, registers[num]`.
+    void Load(unsigned reg, unsigned num)
+    {
+        RegisterOperand(0x8B, reg, num);
+    }
+
+    /// `mov registers[num], reg`.
+    void Store(unsigned num, unsigned reg)
+    {
+        RegisterOperand(0x89, reg, num);
+    }
+
+    /// `mov registers[num], imm`.
+    void StoreImmediate(unsigned num, unsigned imm)
+    {
+        RegisterOperand(0xC7, 0, num);
+        Word(imm);
+    }
+
+    /// `op eax, registers[num]`.
+    void Arith(unsigned op, unsigned num)
+    {
+        RegisterOperand(op << 3 | 0x3, EAX, num);
+    }
+
+    /// `op reg, imm`.
+    void ArithImmediate(unsigned op, unsigned reg, unsigned imm)
+    {
+        Byte(0x81);
+        Byte(0xC0 | op << 3 | reg);
+        Word(imm);
+    }
+
+    /// `shift eax, amount`.
+    void Shift(unsigned shift, unsigned amount)
+    {
+        Byte(0xC1);
+        Byte(0xC0 | shift << 3 | EAX);
+        Byte(amount);
+    }
+
+    /// `shift eax, cl`.
+    void ShiftByCl(unsigned shift)
+    {
+        Byte(0xD3);
+        Byte(0xC0 | shift << 3 | EAX);
+    }
+
+    /// `not eax`.
+    void Not()
+    {
+        Byte(0xF7);
+        Byte(0xD0);
+    }
+
+    /// `setcc al; movzx eax, al`.
+    void SetFromCondition(unsigned cc)
+    {
+        Byte(0x0F);
+        Byte(0x90 | cc);
+        Byte(0xC0);
+        Byte(0x0F);
+        Byte(0xB6);
+        Byte(0xC0);
+    }
+
+    /// `cmovcc dst, src`.
+    void MoveIf(unsigned cc, unsigned dst, unsigned src)
+    {
+        Byte(0x0F);
+        Byte(0x40 | cc);
+        Byte(0xC0 | dst << 3 | src);
+    }
+
+    /// `mul`/`imul registers[num]`, leaving the product in `edx:eax`.
+    void Multiply(bool isSigned, unsigned num)
+    {
+        RegisterOperand(0xF7, isSigned ? 5 : 4, num);
+    }
+
+    /// `lea reg, [r13 + disp]`: an address relative to the block start.
+    void Relative(unsigned reg, int disp)
+    {
+        Byte(0x41);
+        Byte(0x8D);
+        Byte(0x80 | reg << 3 | R13);
+        Word(disp);
+    }
+
+    /// `mov reg, imm`.
+    void MoveImmediate(unsigned reg, unsigned imm)
+    {
+        Byte(0xB8 | reg);
+        Word(imm);
+    }
+
+    /// `mov r8d, imm`.
+    void MoveImmediateR8(unsigned imm)
+    {
+        Byte(0x41);
+        Byte(0xB8);
+        Word(imm);
+    }
+
+    /// `mov dst, src`.
+    void Move(unsigned dst, unsigned src)
+    {
+        Byte(0x89);
+        Byte(0xC0 | src << 3 | dst);
+    }
+
+    /// `mov rdi, r12`.
+    void ContextToFirstArgument()
+    {
+        Byte(0x4C);
+        Byte(0x89);
+        Byte(0xE7);
+    }
+
+    /// `mov rdi, rbx`.
+    void RegistersToFirstArgument()
+    {
+        Byte(0x48);
+        Byte(0x89);
+        Byte(0xDF);
+    }
+
+    void Call(const void *function)
+    {
+        uint64_t target = (uint64_t) function;
+        Byte(0x48);  // mov rax, imm64
+        Byte(0xB8);
+        memcpy(position, &target, 8);
+        position += 8;
+        Byte(0xFF);  // call rax
+        Byte(0xD0);
+    }
+
+    /// Conditional jump to be patched later; returns the location of the
+    /// displacement.
+    unsigned char *JumpIf(unsigned cc)
+    {
+        Byte(0x0F);
+        Byte(0x80 | cc);
+        Word(0);
+        return position - 4;
+    }
+
+    unsigned char *Jump()
+    {
+        Byte(0xE9);
+        Word(0);
+        return position - 4;
+    }
+
+    /// Make the jump with displacement at `patch` land here.
+    void Land(unsigned char *patch)
+    {
+        int disp = (int) (position - (patch + 4));
+        memcpy(patch, &disp, 4);
+    }
+
+private:
+    unsigned char *position;
+};
+
+
+static bool
+IsTranslatable(unsigned opCode)
+{
+    switch (opCode) {
+        case OP_ADDIU: case OP_ADDU: case OP_AND: case OP_ANDI:
+        case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+        case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+        case OP_DIV: case OP_DIVU: case OP_J: case OP_JAL: case OP_JALR:
+        case OP_JR: case OP_LB: case OP_LBU: case OP_LH: case OP_LHU:
+        case OP_LUI: case OP_LW: case OP_MFHI: case OP_MFLO: case OP_MTHI:
+        case OP_MTLO: case OP_MULT: case OP_MULTU: case OP_NOR: case OP_OR:
+        case OP_ORI: case OP_SB: case OP_SH: case OP_SLL: case OP_SLLV:
+        case OP_SLT: case OP_SLTI: case OP_SLTIU: case OP_SLTU: case OP_SRA:
+        case OP_SRAV: case OP_SRL: case OP_SRLV: case OP_SUBU: case OP_SW:
+        case OP_XOR: case OP_XORI:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool
+IsControlTransfer(unsigned opCode)
+{
+    switch (opCode) {
+        case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+        case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+        case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool
+IsLoad(unsigned opCode)
+{
+    return opCode == OP_LB || opCode == OP_LBU || opCode == OP_LH
+           || opCode == OP_LHU || opCode == OP_LW;
+}
+
+/// The register written by a non-load instruction, or -1.
+static int
+Destination(const Instruction *instr)
+{
+    switch (instr->opCode) {
+        case OP_ADDIU: case OP_ANDI: case OP_LUI: case OP_ORI:
+        case OP_SLTI: case OP_SLTIU: case OP_XORI:
+            return instr->rt;
+        case OP_ADDU: case OP_AND: case OP_JALR: case OP_MFHI:
+        case OP_MFLO: case OP_NOR: case OP_OR: case OP_SLL: case OP_SLLV:
+        case OP_SLT: case OP_SLTU: case OP_SRA: case OP_SRAV: case OP_SRL:
+        case OP_SRLV: case OP_SUBU: case OP_XOR:
+            return instr->rd;
+        case OP_BGEZAL: case OP_BLTZAL: case OP_JAL:
+            return RET_ADDR_REG;
+        default:
+            return -1;
+    }
+}
+
+/// Generates the code of one block.
+class BlockWriter {
+public:
+    BlockWriter(char *start) : e(start)
+    {
+        pendingLoad = -1;
+        loadValueIsZero = false;
+        inDelaySlot = false;
+    }
+
+    void Prologue()
+    {
+        e.Byte(0x53);  // push rbx
+        e.Byte(0x41);  // push r12
+        e.Byte(0x54);
+        e.Byte(0x41);  // push r13
+        e.Byte(0x55);
+        e.Byte(0x48);  // mov rbx, rsi
+        e.Byte(0x89);
+        e.Byte(0xF3);
+        e.Byte(0x49);  // mov r12, rdi
+        e.Byte(0x89);
+        e.Byte(0xFC);
+        e.Byte(0x44);  // mov r13d, registers[PC_REG]
+        e.RegisterOperand(0x8B, R13, PC_REG);
+    }
+
+    /// Emit instruction number `k` of the block.
+    void Instruction(const ::Instruction *instr, unsigned k)
+    {
+        unsigned op = instr->opCode;
+        int dst = Destination(instr);
+
+        if (IsLoad(op)) {
+            SyncBefore(k);
+            e.Load(EAX, instr->rs);
+            e.ArithImmediate(ALU_ADD, EAX, instr->extra);
+            e.Move(ESI, EAX);
+            e.MoveImmediate(EDX, op);
+            e.MoveImmediate(ECX, k);
+            e.ContextToFirstArgument();
+            e.Call((const void *) TranslatedLoad);
+            e.Byte(0x48);  // bt rax, 32
+            e.Byte(0x0F);
+            e.Byte(0xBA);
+            e.Byte(0xE0);
+            e.Byte(32);
+            faults[numFaults++] = e.JumpIf(CC_B);
+            Retire(instr->rt, dst);
+            return;
+        }
+
+        if (op == OP_SB || op == OP_SH || op == OP_SW) {
+            SyncBefore(k);
+            e.Load(EAX, instr->rs);
+            e.ArithImmediate(ALU_ADD, EAX, instr->extra);
+            e.Move(ESI, EAX);
+            e.Load(EDX, instr->rt);
+            e.MoveImmediate(ECX, op == OP_SB ? 1 : op == OP_SH ? 2 : 4);
+            e.MoveImmediateR8(k);
+            e.ContextToFirstArgument();
+            e.Call((const void *) TranslatedStore);
+            e.Byte(0x85);  // test eax, eax
+            e.Byte(0xC0);
+            faults[numFaults++] = e.JumpIf(CC_E);
+            Retire(-1, dst);
+            e.ArithImmediate(ALU_CMP, EAX, STORE_CODE_CHANGED);
+            unsigned char *go_on = e.JumpIf(CC_NE);
+            Leave(k);
+            e.Land(go_on);
+            return;
+        }
+
+        if (IsControlTransfer(op)) {
+            Branch(instr, k);
+            Retire(-1, dst);
+            e.Store(NEXT_PC_REG, ECX);
+            inDelaySlot = true;
+            return;
+        }
+
+        switch (op) {
+            case OP_ADDIU:
+                e.Load(EAX, instr->rs);
+                e.ArithImmediate(ALU_ADD, EAX, instr->extra);
+                break;
+            case OP_ADDU:
+                Arith(ALU_ADD, instr);
+                break;
+            case OP_AND:
+                Arith(ALU_AND, instr);
+                break;
+            case OP_ANDI:
+                e.Load(EAX, instr->rs);
+                e.ArithImmediate(ALU_AND, EAX, instr->extra & 0xFFFF);
+                break;
+            case OP_DIV:
+            case OP_DIVU:
+                e.RegistersToFirstArgument();
+                e.MoveImmediate(ESI, instr->rs);
+                e.MoveImmediate(EDX, instr->rt);
+                e.MoveImmediate(ECX, op == OP_DIV);
+                e.Call((const void *) TranslatedDivide);
+                break;
+            case OP_LUI:
+                e.MoveImmediate(EAX, instr->extra << 16);
+                break;
+            case OP_MFHI:
+                e.Load(EAX, HI_REG);
+                break;
+            case OP_MFLO:
+                e.Load(EAX, LO_REG);
+                break;
+            case OP_MTHI:
+                e.Load(EAX, instr->rs);
+                e.Store(HI_REG, EAX);
+                break;
+            case OP_MTLO:
+                e.Load(EAX, instr->rs);
+                e.Store(LO_REG, EAX);
+                break;
+            case OP_MULT:
+            case OP_MULTU:
+                e.Load(EAX, instr->rs);
+                e.Multiply(op == OP_MULT, instr->rt);
+                e.Store(LO_REG, EAX);
+                e.Store(HI_REG, EDX);
+                break;
+            case OP_NOR:
+                Arith(ALU_OR, instr);
+                e.Not();
+                break;
+            case OP_OR:
+                Arith(ALU_OR, instr);
+                break;
+            case OP_ORI:
+                e.Load(EAX, instr->rs);
+                e.ArithImmediate(ALU_OR, EAX, instr->extra & 0xFFFF);
+                break;
+            case OP_SLL:
+                e.Load(EAX, instr->rt);
+                e.Shift(SHIFT_LEFT, instr->extra);
+                break;
+            case OP_SLLV:
+                e.Load(ECX, instr->rs);
+                e.Load(EAX, instr->rt);
+                e.ShiftByCl(SHIFT_LEFT);
+                break;
+            case OP_SLT:
+                Arith(ALU_CMP, instr);
+                e.SetFromCondition(CC_L);
+                break;
+            case OP_SLTI:
+                e.Load(EAX, instr->rs);
+                e.ArithImmediate(ALU_CMP, EAX, instr->extra);
+                e.SetFromCondition(CC_L);
+                break;
+            case OP_SLTIU:
+                e.Load(EAX, instr->rs);
+                e.ArithImmediate(ALU_CMP, EAX, instr->extra);
+                e.SetFromCondition(CC_B);
+                break;
+            case OP_SLTU:
+                Arith(ALU_CMP, instr);
+                e.SetFromCondition(CC_B);
+                break;
+            case OP_SRA:
+            case OP_SRL:  // `ExecInstruction` shifts a signed value.
+                e.Load(EAX, instr->rt);
+                e.Shift(SHIFT_ARITH, instr->extra);
+                break;
+            case OP_SRAV:
+            case OP_SRLV:
+                e.Load(ECX, instr->rs);
+                e.Load(EAX, instr->rt);
+                e.ShiftByCl(SHIFT_ARITH);
+                break;
+            case OP_SUBU:
+                Arith(ALU_SUB, instr);
+                break;
+            case OP_XOR:
+                Arith(ALU_XOR, instr);
+                break;
+            case OP_XORI:
+                e.Load(EAX, instr->rs);
+                e.ArithImmediate(ALU_XOR, EAX, instr->extra & 0xFFFF);
+                break;
+            default:
+                ASSERT(false);
+        }
+        if (dst >= 0) {
+            e.Store(dst, EAX);
+        }
+        Retire(-1, dst);
+    }
+
+    /// Finish the block after instruction `last`.
+    void Epilogue(unsigned last)
+    {
+        Leave(last);
+
+        // Common exit for exceptions.
+        for (unsigned i = 0; i < numFaults; i++) {
+            e.Land(faults[i]);
+        }
+        e.MoveImmediate(EAX, (unsigned) -1);
+        unsigned char *out = e.Jump();
+
+        for (unsigned i = 0; i < numReturns; i++) {
+            e.Land(returns[i]);
+        }
+        e.Land(out);
+        e.Byte(0x41);  // pop r13
+        e.Byte(0x5D);
+        e.Byte(0x41);  // pop r12
+        e.Byte(0x5C);
+        e.Byte(0x5B);  // pop rbx
+        e.Byte(0xC3);  // ret
+    }
+
+    char *Position() const
+    {
+        return e.Position();
+    }
+
+private:
+
+    /// `eax = rs op rt` for an R-format instruction.
+    void Arith(unsigned alu, const ::Instruction *instr)
+    {
+        e.Load(EAX, instr->rs);
+        e.Arith(alu, instr->rt);
+    }
+
+    /// Compute in `ecx` the next PC after branch or jump number `k`.
+    void Branch(const ::Instruction *instr, unsigned k)
+    {
+        unsigned op = instr->opCode;
+        int sequential = 4 * k + 8;
+        int target = 4 * k + 4 + IndexToAddr(instr->extra);
+
+        if (op == OP_BGEZAL || op == OP_BLTZAL || op == OP_JAL) {
+            e.Relative(EAX, sequential);
+            e.Store(RET_ADDR_REG, EAX);
+        }
+
+        switch (op) {
+            case OP_BEQ:
+            case OP_BNE:
+                Arith(ALU_CMP, instr);
+                ChooseTarget(op == OP_BEQ ? CC_E : CC_NE,
+                             sequential, target);
+                break;
+            case OP_BGEZ:
+            case OP_BGEZAL:
+            case OP_BGTZ:
+            case OP_BLEZ:
+            case OP_BLTZ:
+            case OP_BLTZAL:
+                e.Load(EAX, instr->rs);
+                e.ArithImmediate(ALU_CMP, EAX, 0);
+                ChooseTarget(op == OP_BGTZ ? CC_G :
+                             op == OP_BLEZ ? CC_LE :
+                             op == OP_BLTZ || op == OP_BLTZAL ? CC_L :
+                                                                CC_GE,
+                             sequential, target);
+                break;
+            case OP_J:
+            case OP_JAL:
+                e.Relative(ECX, sequential);
+                e.ArithImmediate(ALU_AND, ECX, 0xF0000000);
+                e.ArithImmediate(ALU_OR, ECX, IndexToAddr(instr->extra));
+                break;
+            case OP_JALR:
+                e.Relative(EAX, sequential);
+                e.Store(instr->rd, EAX);
+                e.Load(ECX, instr->rs);
+                break;
+            case OP_JR:
+                e.Load(ECX, instr->rs);
+                break;
+        }
+    }
+
+    /// `ecx = flags say cc ? target : sequential`.
+    void ChooseTarget(unsigned cc, int sequential, int target)
+    {
+        e.Relative(ECX, sequential);
+        e.Relative(EDX, target);
+        e.MoveIf(cc, ECX, EDX);
+    }
+
+    /// Do what `DelayedLoad` does at the end of an instruction: `load` is
+    /// the register loaded by it (or -1), and `dst` the register it wrote
+    /// directly (or -1).  Only `edx` is used, besides the loaded value in
+    /// `eax`.
+    void Retire(int load, int dst)
+    {
+        if (pendingLoad >= 0) {
+            e.Load(EDX, LOAD_VALUE_REG);
+            e.Store(pendingLoad, EDX);
+        }
+        if (load >= 0) {
+            e.StoreImmediate(LOAD_REG, load);
+            e.Store(LOAD_VALUE_REG, EAX);
+            loadValueIsZero = false;
+        } else {
+            if (pendingLoad >= 0) {
+                e.StoreImmediate(LOAD_REG, 0);
+            }
+            if (!loadValueIsZero) {
+                e.StoreImmediate(LOAD_VALUE_REG, 0);
+                loadValueIsZero = true;
+            }
+        }
+        if (pendingLoad == 0 || dst == 0) {
+            e.StoreImmediate(0, 0);
+        }
+        pendingLoad = load;
+    }
+
+    /// Write the program counters as the interpreter has them while
+    /// running instruction `k`.
+    void SyncBefore(unsigned k)
+    {
+        if (k > 0) {
+            e.Relative(EAX, 4 * k - 4);
+            e.Store(PREV_PC_REG, EAX);
+        }
+        e.Relative(EAX, 4 * k);
+        e.Store(PC_REG, EAX);
+        if (!inDelaySlot) {
+            e.Relative(EAX, 4 * k + 4);
+            e.Store(NEXT_PC_REG, EAX);
+        }
+    }
+
+    /// Leave the block right after instruction `k`.
+    void Leave(unsigned k)
+    {
+        e.Relative(EAX, 4 * k);
+        e.Store(PREV_PC_REG, EAX);
+        if (inDelaySlot) {
+            e.Load(EAX, NEXT_PC_REG);
+            e.Store(PC_REG, EAX);
+            e.ArithImmediate(ALU_ADD, EAX, 4);
+            e.Store(NEXT_PC_REG, EAX);
+        } else {
+            e.Relative(EAX, 4 * k + 4);
+            e.Store(PC_REG, EAX);
+            e.Relative(EAX, 4 * k + 8);
+            e.Store(NEXT_PC_REG, EAX);
+        }
+        e.MoveImmediate(EAX, k + 1);
+        returns[numReturns++] = e.Jump();
+    }
+
+    Emitter e;
+
+    /// Register loaded by the previous instruction, or -1.
+    int pendingLoad;
+
+    /// Whether `LOAD_VALUE_REG` is known to be zero.
+    bool loadValueIsZero;
+
+    /// Whether the instruction being emitted is in a delay slot.
+    bool inDelaySlot;
+
+    /// Jumps to the exits of the block.
+    unsigned char *faults[MAX_BLOCK_LENGTH];
+    unsigned numFaults = 0;
+    unsigned char *returns[MAX_BLOCK_LENGTH + 1];
+    unsigned numReturns = 0;
+};
+
+
+Translator::Translator(Machine *m, DecodeCache *decodeCache,
+                       unsigned numFrames_, unsigned frameSize_)
+{
+    ASSERT(m != nullptr);
+    ASSERT(decodeCache != nullptr);
+
+    machine   = m;
+    cache     = decodeCache;
+    numFrames = numFrames_;
+    frameSize = frameSize_;
+
+    words       = new CodeWord * [numFrames];
+    generations = new unsigned [numFrames];
+    for (unsigned i = 0; i < numFrames; i++) {
+        words[i]       = nullptr;
+        generations[i] = cache->Generation(i);
+    }
+
+    void *buffer = mmap(nullptr, CODE_SIZE,
+                        PROT_READ | PROT_WRITE | PROT_EXEC,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT(buffer != MAP_FAILED);
+    code     = (char *) buffer;
+    codeUsed = 0;
+}
+
+Translator::~Translator()
+{
+    for (unsigned i = 0; i < numFrames; i++) {
+        Forget(i);
+        delete [] words[i];
+    }
+    delete [] words;
+    delete [] generations;
+    munmap(code, CODE_SIZE);
+}
+
+const TranslatedBlock *
+Translator::Find(unsigned physAddr)
+{
+    unsigned frame = physAddr / frameSize;
+    if (generations[frame] != cache->Generation(frame)) {
+        Forget(frame);
+    }
+
+    CodeWord *word = &Words(frame)[physAddr % frameSize / 4];
+    TranslatedBlock *block = word->block;
+    if (block == nullptr) {
+        if (++word->heat < HOT_THRESHOLD) {
+            return nullptr;
+        }
+        block = word->block = Translate(physAddr);
+    }
+    return block == &untranslatable ? nullptr : block;
+}
+
+Translator::CodeWord *
+Translator::Words(unsigned frame)
+{
+    if (words[frame] == nullptr) {
+        words[frame] = new CodeWord [frameSize / 4];
+        for (unsigned i = 0; i < frameSize / 4; i++) {
+            words[frame][i].block = nullptr;
+            words[frame][i].heat  = 0;
+        }
+    }
+    return words[frame];
+}
+
+bool
+Translator::Execute(const TranslatedBlock *block, unsigned physAddr,
+                    int *registers)
+{
+    ASSERT(block != nullptr);
+
+    TranslationContext context;
+    context.machine    = machine;
+    context.cache      = cache;
+    context.frame      = physAddr / frameSize;
+    context.generation = cache->Generation(context.frame);
+    context.committed  = 0;
+
+    int done = block->code(&context, registers);
+    if (done < 0) {
+        machine->RaiseException(context.exception, context.badAddr);
+        return false;
+    }
+    Commit(&context, done);
+    return true;
+}
+
+TranslatedBlock *
+Translator::Translate(unsigned physAddr)
+{
+    if (CODE_SIZE - codeUsed < MAX_BLOCK_CODE) {
+        Flush();
+    }
+
+    // Collect the instructions of the block.
+    Instruction instrs[MAX_BLOCK_LENGTH];
+    unsigned length = 0;
+    unsigned end = (physAddr / frameSize + 1) * frameSize;
+    for (unsigned addr = physAddr;
+         addr < end && length + 2 <= MAX_BLOCK_LENGTH; addr += 4) {
+        const Instruction *instr = cache->Lookup(addr);
+        if (!IsTranslatable(instr->opCode)) {
+            break;
+        }
+        if (IsControlTransfer(instr->opCode)) {
+            if (addr + 4 >= end) {
+                break;
+            }
+            const Instruction *slot = cache->Lookup(addr + 4);
+            if (!IsTranslatable(slot->opCode)
+                  || IsControlTransfer(slot->opCode)) {
+                break;
+            }
+            instrs[length++] = *instr;
+            instrs[length++] = *slot;
+            break;
+        }
+        instrs[length++] = *instr;
+    }
+    if (length == 0) {
+        return &untranslatable;
+    }
+
+    BlockWriter writer(code + codeUsed);
+    writer.Prologue();
+    for (unsigned k = 0; k < length; k++) {
+        writer.Instruction(&instrs[k], k);
+        cache->Watch(physAddr + 4 * k);
+    }
+    writer.Epilogue(length - 1);
+
+    TranslatedBlock *block = new TranslatedBlock;
+    block->length = length;
+    block->code   = (BlockCode) (code + codeUsed);
+    codeUsed = writer.Position() - code;
+    ASSERT(codeUsed <= CODE_SIZE);
+    DEBUG('j', "Translated %u instructions at physical address 0x%X\n",
+          length, physAddr);
+    return block;
+}
+
+void
+Translator::Forget(unsigned frame)
+{
+    CodeWord *frameWords = words[frame];
+    if (frameWords != nullptr) {
+        for (unsigned i = 0; i < frameSize / 4; i++) {
+            if (frameWords[i].block != &untranslatable) {
+                delete frameWords[i].block;
+            }
+            frameWords[i].block = nullptr;
+            frameWords[i].heat  = 0;
+        }
+    }
+    generations[frame] = cache->Generation(frame);
+}
+
+void
+Translator::Flush()
+{
+    DEBUG('j', "Code buffer full, dropping every translation\n");
+    for (unsigned i = 0; i < numFrames; i++) {
+        Forget(i);
+    }
+    codeUsed = 0;
+}
+
+
+/// Like the loop in `Machine::Run`, but running translated blocks whenever
+/// possible.
+///
+/// Blocks are only entered outside delay slots and with no delayed load in
+/// progress, which is what they assume.
+void
+Machine::RunTranslated()
+{
+    for (;;) {
+        const Instruction *instr;
+        unsigned physAddr;
+        ExceptionType e = mmu.ReadInstruction(registers[PC_REG], &instr,
+                                              &physAddr);
+        if (e != NO_EXCEPTION) {
+            RaiseException(e, registers[PC_REG]);
+            Tick();
+            continue;
+        }
+
+        if (registers[LOAD_REG] == 0
+              && (unsigned) registers[NEXT_PC_REG]
+                 == (unsigned) registers[PC_REG] + 4) {
+            const TranslatedBlock *block = translator->Find(physAddr);
+            if (block != nullptr
+                  && block->length <= tickBudget) {
+                if (!translator->Execute(block, physAddr, registers)) {
+                    Tick();  // For the faulting instruction.
+                }
+                continue;
+            }
+        }
+
+        ExecInstruction(instr);
+        Tick();
+    }
+}
+
+#endif
@@ -30,7 +30,6 @@ Condition::Condition(const char *debugName, Lock *conditionLock)
 
 Condition::~Condition()
 {
-    list->~List();
     delete list;
 }
 
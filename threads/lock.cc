@@ -27,7 +27,6 @@ Lock::Lock(const char *debugName)
 
 Lock::~Lock()
 {
-    sem->~Semaphore();
     delete sem;
 }
 
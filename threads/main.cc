@@ -12,7 +12,11 @@
 ///
 ///     nachos [-d <debugflags>] [-do <debugopts>] [-p]
 ///            [-rs <random seed #>] [-z] [-tt]
-///            [-s] [-x <nachos file>] [-tc <consoleIn> <consoleOut>]
+///            [-s] [-pu] [-m <physical pages>] [-ck <unix file>]
+///            [-smp <processors>] [-x <nachos file>]
+///            [-rk <unix file>] [-tc <consoleIn> <consoleOut>]
+///            [-rp <replacement policy>] [-ts <TLB entries>]
+///            [-ta <TLB ways>] [-tp <TLB policy>]
 ///            [-f] [-cp <unix file> <nachos file>] [-pr <nachos file>]
 ///            [-rm <nachos file>] [-ls] [-D] [-c] [-tf]
 ///            [-n <network reliability>] [-id <machine id>]
@@ -39,9 +43,29 @@
 /// ----------------------
 ///
 /// * `-s`  -- causes user programs to be executed in single-step mode.
+/// * `-pu` -- profiles user programs, reporting their hottest procedures
+///            when they exit or halt the machine.
+/// * `-m`  -- sets the number of frames of physical memory, 128 by default.
+/// * `-ck` -- sets the UNIX file where user programs save a checkpoint
+///            (see `userprog/checkpoint.hh`).
+/// * `-smp` -- sets the number of processors, up to 16; 1 by default, and
+///            always without *VMEM* (see `userprog/multiprocessor.hh`).
 /// * `-x`  -- runs a user program.
+/// * `-rk` -- resumes a user program from a checkpoint.
 /// * `-tc` -- tests the console.
 ///
+/// *VMEM* options
+/// --------------
+///
+/// * `-rp` -- sets the page replacement policy: `fifo` (the default),
+///            `clock`, `enhanced` or `lru` (see `vmem/core_map.hh`).
+/// * `-ts` -- sets the number of TLB entries, a power of two from 2 to
+///            512.
+/// * `-ta` -- sets the associativity of the TLB: the entries of a set, a
+///            power of two, at least 2; by default, all of them.
+/// * `-tp` -- sets how the TLB replaces entries of a set: `random`, `rr`
+///            (in turn, the default) or `lru`.
+///
 /// *FILESYS* options
 /// -----------------
 ///
@@ -92,6 +116,7 @@ void Copy(const char *unixFile, const char *nachosFile);
 void Print(const char *file);
 void PerformanceTest(void);
 void StartProcess(const char *file);
+void StartFromCheckpoint(const char *file);
 void SynchConsoleTest(const char *in, const char *out);
 void SynchConsoleTest2(const char *in, const char *out);
 void ConsoleTest(const char *in, const char *out);
@@ -145,6 +170,10 @@ main(int argc, char **argv)
             ASSERT(argc > 1);
             StartProcess(*(argv + 1));
             argCount = 2;
+        } else if (!strcmp(*argv, "-rk")) {  // Resume a user program.
+            ASSERT(argc > 1);
+            StartFromCheckpoint(*(argv + 1));
+            argCount = 2;
         } else if (!strcmp(*argv, "-tc")) {  // Test the console.
             if (argc == 1) {
                 SynchConsoleTest(nullptr, nullptr);
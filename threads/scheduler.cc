@@ -53,6 +53,11 @@ Scheduler::ReadyToRun(Thread *thread)
 
     thread->SetStatus(READY);
     readyList[thread->GetPriority()]->Append(thread);
+#ifdef USER_PROGRAM
+    if (multiprocessor != nullptr) {
+        multiprocessor->Wake();
+    }
+#endif
 }
 
 ///
@@ -87,12 +92,54 @@ Scheduler::FindNextToRun()
     for (unsigned int i = 0 ; i < MAX_PRIORITY ; i++)
     {
         unsigned int index = MAX_PRIORITY - i - 1;
+#ifdef USER_PROGRAM
+        // Skip the threads bound to other processors.
+        if (multiprocessor != nullptr) {
+            Thread *thread = PopRunnable(readyList[index]);
+            if (thread != nullptr)
+                return thread;
+            continue;
+        }
+#endif
         if (!readyList[index]->IsEmpty())
             return readyList[index]->Pop();
     }
     return nullptr;
 }
 
+#ifdef USER_PROGRAM
+Thread *
+Scheduler::PopRunnable(List<Thread *> *list)
+{
+    List<Thread *> skipped;
+    Thread *thread;
+    while ((thread = list->Pop()) != nullptr
+             && !multiprocessor->MayRun(thread)) {
+        skipped.Append(thread);
+    }
+    // The skipped threads go back in front, in their order.
+    Thread *other;
+    while ((other = list->Pop()) != nullptr) {
+        skipped.Append(other);
+    }
+    while ((other = skipped.Pop()) != nullptr) {
+        list->Append(other);
+    }
+    return thread;
+}
+#endif
+
+bool
+Scheduler::HasReadyThreads() const
+{
+    for (unsigned int i = 0 ; i < MAX_PRIORITY ; i++)
+    {
+        if (!readyList[i]->IsEmpty())
+            return true;
+    }
+    return false;
+}
+
 /// Dispatch the CPU to `nextThread`.
 ///
 /// Save the state of the old thread, and load the state of the new thread,
@@ -116,6 +163,9 @@ Scheduler::Run(Thread *nextThread)
         // If this thread is a user program, save the user's CPU registers.
         currentThread->SaveUserState();
         currentThread->space->SaveState();
+        if (multiprocessor != nullptr) {
+            currentThread->processor = multiprocessor->GetCurrent();
+        }
     }
 #endif
 
@@ -160,9 +210,17 @@ Scheduler::Run(Thread *nextThread)
 ///
 void 
 Scheduler::UpdatePriority(Thread *thread, unsigned int newPriority) {
-    readyList[thread->GetPriority()]->Remove(thread);
+    // A thread that is blocked, for instance on a disk request, only takes
+    // the new priority; putting it on the ready list would wake it up
+    // before its semaphore is signalled.
+    bool ready = readyList[thread->GetPriority()]->Has(thread);
+    if (ready) {
+        readyList[thread->GetPriority()]->Remove(thread);
+    }
     thread->SetPriority(newPriority);
-    readyList[newPriority]->Append(thread);  
+    if (ready) {
+        readyList[newPriority]->Append(thread);
+    }
 }
 
 /// Print the scheduler state -- in other words, the contents of the ready
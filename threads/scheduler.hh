@@ -42,6 +42,9 @@ public:
     /// Dequeue first thread on the ready list, if any, and return thread.
     Thread *FindNextToRun();
 
+    /// Whether some thread is ready to run.
+    bool HasReadyThreads() const;
+
     /// Cause `nextThread` to start running.
     void Run(Thread *nextThread);
 
@@ -53,6 +56,12 @@ public:
 
 private:
 
+#ifdef USER_PROGRAM
+    /// Remove and return the first thread of `list` that the current
+    /// processor may run, if any.
+    Thread *PopRunnable(List<Thread *> *list);
+#endif
+
     // Queue of threads that are ready to run, but not running.
     List<Thread*> *readyList[10];
     List<Thread*> *zombieList;
@@ -51,10 +51,11 @@ General:\n\
     printf("\n\
 Memory:\n\
   Page size: %u bytes.\n\
-  Number of pages: %u.\n\
+  Number of pages: %u by default, at most %u.\n\
   Number of TLB entries: %u.\n\
-  Memory size: %u bytes.\n",
-      PAGE_SIZE, NUM_PHYS_PAGES, TLB_SIZE, MEMORY_SIZE);
+  Memory size: %u bytes by default.\n",
+      PAGE_SIZE, DEFAULT_NUM_PHYS_PAGES, MAX_NUM_PHYS_PAGES, TLB_SIZE,
+      DEFAULT_NUM_PHYS_PAGES * PAGE_SIZE);
     printf("\n\
 Disk:\n\
   Sector size: %u bytes.\n\
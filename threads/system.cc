@@ -45,9 +45,19 @@ SynchDisk *synchDisk;
 
 #ifdef USER_PROGRAM  // Requires either *FILESYS* or *FILESYS_STUB*.
 Machine *machine;    ///< User program memory and registers.
-Bitmap *bitmap;      ///
+Multiprocessor *multiprocessor = nullptr;
+FrameTable *frameTable;
+TextCache *textCache;
+AsyncIo *asyncIo;
 SynchConsole *synchConsole;
 ListThreadSpace tableThread;
+bool profileUserPrograms = false;
+unsigned numUserPrograms = 0;
+const char *checkpointPath = nullptr;
+#endif
+
+#ifdef VMEM
+CoreMap *coreMap;
 #endif
 
 #ifdef NETWORK
@@ -140,6 +150,16 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     bool debugUserProg = false;  // Single step user program.
+    unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES;
+    unsigned numProcessors = 1;
+#endif
+#ifdef VMEM
+    ReplacementPolicy replacementPolicy = REPLACE_FIFO;
+#endif
+#ifdef USE_TLB
+    unsigned tlbSize = TLB_SIZE;
+    unsigned tlbWays = 0;  // As many as entries: fully associative.
+    TLBPolicy tlbPolicy = TLB_ROUND_ROBIN;
 #endif
 #ifdef FILESYS_NEEDED
     bool format = false;  // Format disk.
@@ -183,6 +203,44 @@ Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-s")) {
             debugUserProg = true;
+        } else if (!strcmp(*argv, "-pu")) {
+            profileUserPrograms = true;
+        } else if (!strcmp(*argv, "-m")) {
+            ASSERT(argc > 1);
+            numPhysPages = atoi(*(argv + 1));
+            ASSERT(numPhysPages > 0 && numPhysPages <= MAX_NUM_PHYS_PAGES);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-ck")) {
+            ASSERT(argc > 1);
+            checkpointPath = *(argv + 1);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-smp")) {
+            ASSERT(argc > 1);
+            numProcessors = atoi(*(argv + 1));
+            ASSERT(numProcessors > 0 && numProcessors <= MAX_PROCESSORS);
+            argCount = 2;
+        }
+#endif
+#ifdef VMEM
+        if (!strcmp(*argv, "-rp")) {
+            ASSERT(argc > 1);
+            ASSERT(ParseReplacementPolicy(*(argv + 1), &replacementPolicy));
+            argCount = 2;
+        }
+#endif
+#ifdef USE_TLB
+        if (!strcmp(*argv, "-ts")) {
+            ASSERT(argc > 1);
+            tlbSize = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-ta")) {
+            ASSERT(argc > 1);
+            tlbWays = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-tp")) {
+            ASSERT(argc > 1);
+            ASSERT(ParseTLBPolicy(*(argv + 1), &tlbPolicy));
+            argCount = 2;
         }
 #endif
 #ifdef FILESYS_NEEDED
@@ -231,17 +289,39 @@ Initialize(int argc, char **argv)
 
 #ifdef USER_PROGRAM
     Debugger *d = debugUserProg ? new Debugger : nullptr;
-    machine = new Machine(d);  // This must come first.
+    machine = new Machine(d, numPhysPages);  // This must come first.
+#ifdef USE_TLB
+    machine->GetMMU()->SetUpTLB(tlbSize, tlbWays == 0 ? tlbSize : tlbWays,
+                                tlbPolicy);
+#endif
     synchConsole = new SynchConsole(nullptr,nullptr);
-    bitmap = new Bitmap(NUM_PHYS_PAGES);
-    tableThread = static_cast<ListThreadSpace>(malloc(sizeof(ListThreadSpace) * MAX_SPACE));
+    frameTable = new FrameTable(numPhysPages);
+    textCache = new TextCache(numPhysPages);
+    // A single worker: the disk serves one request at a time anyway, and
+    // the file system does not keep concurrent writes to a sector apart.
+    asyncIo = new AsyncIo(1);
+#ifdef VMEM
+    coreMap = new CoreMap(frameTable, replacementPolicy);
+#endif
+    tableThread = static_cast<ListThreadSpace>(malloc(sizeof(ListTS) * MAX_SPACE));
     for (int i = 0 ; i < MAX_SPACE ; i++) {
         tableThread[i].space = nullptr;
-        //tableThread[i].thread = nullptr; // esto rompe nose porque
+        tableThread[i].thread = nullptr;
     }
-    if(!randomYield)
+    // With several processors, threads yield at the end of every slice of
+    // their own instead.
+    if(!randomYield && numProcessors == 1)
         timer = new Timer(TimerInterruptHandler, 0, false);
     SetExceptionHandlers();
+    if (numProcessors > 1) {
+        // Single stepping stops one processor only, and the TLBs of the
+        // others could not be flushed when pages are replaced.
+        ASSERT(!debugUserProg);
+#ifdef VMEM
+        ASSERT(false);
+#endif
+        multiprocessor = new Multiprocessor(numProcessors, machine);
+    }
 #endif
 
 #ifdef FILESYS
@@ -255,6 +335,12 @@ Initialize(int argc, char **argv)
 #ifdef NETWORK
     postOffice = new PostOffice(netname, rely, 10);
 #endif
+
+#ifdef USER_PROGRAM
+    if (multiprocessor != nullptr) {
+        multiprocessor->Start();
+    }
+#endif
 }
 
 /// Nachos is halting.  De-allocate global data structures.
@@ -273,10 +359,16 @@ Cleanup()
 #ifdef USER_PROGRAM
     delete machine;
     //delete synchConsole; //PROBAR: ACT esto tira un doble free hay que revisar donde se borra
-    delete bitmap;
+    delete frameTable;
+    delete textCache;
+    delete asyncIo;
     delete tableThread;
 #endif
 
+#ifdef VMEM
+    delete coreMap;
+#endif
+
 #ifdef FILESYS_NEEDED
     delete fileSystem;
 #endif
@@ -36,8 +36,11 @@ extern Timer *timer;                 ///< The hardware alarm clock.
 
 #ifdef USER_PROGRAM
 #include "machine/machine.hh"
-#include "lib/bitmap.hh"
 #include "lib/table.hh"
+#include "userprog/async_io.hh"
+#include "userprog/frame_table.hh"
+#include "userprog/multiprocessor.hh"
+#include "userprog/text_cache.hh"
 
 #define MAX_SPACE 10
 typedef int SpaceId;
@@ -49,9 +52,25 @@ typedef struct
 typedef ListTS* ListThreadSpace;
 
 extern Machine *machine;  // User program memory and registers.
+extern Multiprocessor *multiprocessor;  ///< The processors, if more than
+                                        ///< one.
 extern SynchConsole *synchConsole;
-extern Bitmap *bitmap;
+extern FrameTable *frameTable;  ///< Frames of physical memory in use.
+extern TextCache *textCache;  ///< Code shared among address spaces.
+extern AsyncIo *asyncIo;  ///< File transfers carried out in the
+                         ///< background.
 extern ListThreadSpace tableThread;
+extern bool profileUserPrograms;  ///< Whether to profile every address
+                                  ///< space.
+extern unsigned numUserPrograms;  ///< User programs started and not
+                                  ///< exited yet.
+extern const char *checkpointPath;  ///< Where `Checkpoint` saves user
+                                    ///< programs, if anywhere.
+#endif
+
+#ifdef VMEM
+#include "vmem/core_map.hh"
+extern CoreMap *coreMap;  ///< Frames of physical memory.
 #endif
 
 #ifdef FILESYS_NEEDED  // *FILESYS* or *FILESYS_STUB*.
@@ -51,8 +51,10 @@ Thread::Thread(const char *threadName, bool joinable, unsigned int initialPriori
     status   = JUST_CREATED;
     selfDestruct = !joinable;
     threadFather = currentThread;
+    diskTicks    = 0;
 #ifdef USER_PROGRAM
     space    = nullptr;
+    processor = -1;
     fileTable = new Table<OpenFile*>();
     fileTable->Add(NULL); // Fd falsos para simular consola
     fileTable->Add(NULL); // Fd falsos para simular consola
@@ -267,6 +269,14 @@ Thread::Sleep()
         status = BLOCKED;
     }
     while ((nextThread = scheduler->FindNextToRun()) == nullptr) {
+#ifdef USER_PROGRAM
+        // Other processors may make threads ready, so waiting is left to
+        // the idle thread of this one.
+        if (multiprocessor != nullptr) {
+            nextThread = multiprocessor->GetIdleThread();
+            break;
+        }
+#endif
         interrupt->Idle();  // No one to run, wait for an interrupt.
     }
 
@@ -390,4 +400,15 @@ Thread::GetOpenFileByFileId(int fid)
     return fileTable->Get(fid);
 }
 
+bool
+Thread::HasOpenFiles() const
+{
+    for (unsigned i = 2; i < Table<OpenFile*>::SIZE; i++) {
+        if (fileTable->HasKey(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 #endif
@@ -147,6 +147,9 @@ public:
 
     void Print() const;
 
+    /// Simulated time that the disk spent serving requests of this thread.
+    unsigned long diskTicks;
+
 private:
     // Some of the private data for this class is listed above.
 
@@ -190,12 +193,20 @@ public:
     // User code this thread is running.
     AddressSpace *space;
 
+    /// Processor that the thread must run on, or -1 if any will do (see
+    /// `userprog/multiprocessor.hh`).  Its stack holds the simulation loop
+    /// of the machine of that processor, once it runs user code.
+    int processor;
+
     int AddOpenFile(OpenFile *openFile);
 
     bool DeleteOpenFile(int fid);
 
     OpenFile* GetOpenFileByFileId(int fid);
 
+    /// Whether the thread has open files, besides the console.
+    bool HasOpenFiles() const;
+
 #endif
 };
 
@@ -0,0 +1,31 @@
+/// Benchmark of the simulated CPU: integer arithmetic, shifts and branches,
+/// with almost no memory accesses.
+///
+/// Part of the corpus run by `userprog/bench.sh`.
+
+
+#include "syscall.h"
+
+
+#define ROUNDS  200000
+
+int
+main(void)
+{
+    unsigned x = 0x12345678, sum = 0;
+    int i;
+
+    for (i = 0; i < ROUNDS; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        if (x & 1) {
+            sum += x / 7;
+        } else {
+            sum -= x % 13;
+        }
+        sum = sum * 31 + (x < sum);
+    }
+
+    return sum & 0xFF;
+}
@@ -15,12 +15,8 @@ unsigned strlen(const char *s)
 
 void strput(const char *s)
 {
-    int len = strlen(s);
-    char z[len + 1];
-    int i = 0;
-    for (; i < len; i++) z[i] = s[i];
-    z[i++] = '\n';
-    Write(z, len + 1, CONSOLE_OUTPUT);
+    IoPiece pieces[2] = { { (char *) s, strlen(s) }, { "\n", 1 } };
+    WriteV(pieces, 2, CONSOLE_OUTPUT);
 }
 
 void swap(char *x, char *y) {
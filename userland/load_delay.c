@@ -0,0 +1,77 @@
+/// Check the load delay slot as the simulator implements it.
+///
+/// A MIPS I load does not write its register until after the following
+/// instruction, so a branch or jump right after a load still sees the old
+/// value.  Both tests are written by hand, with `noreorder`, so that the
+/// assembler does not fill the slot with a `nop`.  Run it under each
+/// simulation engine; every line should say "ok".
+
+
+#include "syscall.h"
+#include "../userprog/syscall.h" // Include fix IntelliSense
+#include "lib.h"
+
+
+/// Return 1 if a `bne` right after a `lw` of the same register sees the
+/// value from before the load.
+static int
+LoadThenBranch(const int *zero)
+{
+    int old;
+    __asm__ volatile(
+        ".set push\n\t"
+        ".set noreorder\n\t"
+        "li    %0, 0\n\t"
+        "li    $8, 1\n\t"
+        "lw    $8, 0(%1)\n\t"
+        "bne   $8, $0, 1f\n\t"
+        "nop\n\t"
+        "b     2f\n\t"
+        "nop\n"
+        "1:\n\t"
+        "li    %0, 1\n"
+        "2:\n\t"
+        ".set pop"
+        : "=&r" (old) : "r" (zero) : "$8");
+    return old;
+}
+
+/// Return 1 if a `jr` right after a `lw` of the same register jumps to the
+/// address held before the load.
+static int
+LoadThenJump(void)
+{
+    int old;
+    __asm__ volatile(
+        ".set push\n\t"
+        ".set noreorder\n\t"
+        "li    %0, 0\n\t"
+        "la    $8, 3f\n\t"
+        "addiu $sp, $sp, -8\n\t"
+        "sw    $8, 0($sp)\n\t"
+        "la    $8, 1f\n\t"
+        "lw    $8, 0($sp)\n\t"
+        "jr    $8\n\t"
+        "nop\n"
+        "1:\n\t"
+        "b     2f\n\t"
+        "li    %0, 1\n"
+        "3:\n\t"
+        "b     2f\n\t"
+        "nop\n"
+        "2:\n\t"
+        "addiu $sp, $sp, 8\n\t"
+        ".set pop"
+        : "=&r" (old) : : "$8", "memory");
+    return old;
+}
+
+int
+main(void)
+{
+    int zero = 0;
+
+    strput(LoadThenBranch(&zero) ? "branch: ok" : "branch: FAILED");
+    strput(LoadThenJump() ? "jump: ok" : "jump: FAILED");
+    return 0;
+}
@@ -0,0 +1,41 @@
+/// Benchmark of memory accesses: word, half-word and byte loads and stores
+/// over a buffer, with several strides.
+///
+/// Part of the corpus run by `userprog/bench.sh`.  The buffer is small
+/// enough to fit in physical memory without virtual memory.
+
+
+#include "syscall.h"
+
+
+#define WORDS   256
+#define PASSES  200
+
+static int buffer[WORDS];
+
+int
+main(void)
+{
+    unsigned char *bytes = (unsigned char *) buffer;
+    unsigned short *halves = (unsigned short *) buffer;
+    int pass, i, sum = 0;
+
+    for (i = 0; i < WORDS; i++) {
+        buffer[i] = i;
+    }
+
+    for (pass = 0; pass < PASSES; pass++) {
+        int stride = 1 + pass % 7;
+        for (i = 0; i < WORDS; i += stride) {
+            buffer[i] += buffer[(i + stride) % WORDS];
+        }
+        for (i = 0; i < WORDS * 2; i += stride) {
+            halves[i] ^= (unsigned short) pass;
+        }
+        for (i = pass % 4; i < WORDS * 4; i += 4) {
+            sum += bytes[i];
+        }
+    }
+
+    return sum & 0xFF;
+}
@@ -0,0 +1,51 @@
+/// Benchmark of paging: a buffer bigger than physical memory, accessed with
+/// the patterns of real programs -- sequential scans, a hot region touched
+/// again and again, and scattered updates.
+///
+/// Part of the corpus run by `vmem/replacement.sh`.  Only the *VMEM* kernels
+/// can run it.
+
+
+#include "syscall.h"
+
+
+#define PAGE_WORDS  32     // Words per page.
+#define PAGES       192    // Half again as many as the frames.
+#define HOT_PAGES   24
+#define ROUNDS      8
+
+static int buffer[PAGES * PAGE_WORDS];
+
+int
+main(void)
+{
+    unsigned x = 12345;
+    int round, i, sum = 0;
+
+    for (i = 0; i < PAGES * PAGE_WORDS; i++) {
+        buffer[i] = i;
+    }
+
+    for (round = 0; round < ROUNDS; round++) {
+        // Read everything once.
+        for (i = 0; i < PAGES * PAGE_WORDS; i += PAGE_WORDS / 4) {
+            sum += buffer[i];
+        }
+        // Keep working on the hot region, mostly reading it.
+        for (i = 0; i < HOT_PAGES * PAGE_WORDS * 4; i++) {
+            int j = i % (HOT_PAGES * PAGE_WORDS);
+            if (i % 16 == 0) {
+                buffer[j] += round;
+            } else {
+                sum += buffer[j];
+            }
+        }
+        // Update scattered words.
+        for (i = 0; i < PAGES; i++) {
+            x = x * 1103515245 + 12345;
+            buffer[(x >> 8) % (PAGES * PAGE_WORDS)] ^= sum;
+        }
+    }
+
+    return sum & 0xFF;
+}
@@ -125,6 +125,62 @@ Write:
         j       $31
         .end    Write
 
+        .globl  ReadV
+        .ent    ReadV
+ReadV:
+        addiu   $2, $0, SC_READV
+        syscall
+        j       $31
+        .end    ReadV
+
+        .globl  WriteV
+        .ent    WriteV
+WriteV:
+        addiu   $2, $0, SC_WRITEV
+        syscall
+        j       $31
+        .end    WriteV
+
+        .globl  Enter
+        .ent    Enter
+Enter:
+        addiu   $2, $0, SC_ENTER
+        syscall
+        j       $31
+        .end    Enter
+
+        .globl  AsyncRead
+        .ent    AsyncRead
+AsyncRead:
+        addiu   $2, $0, SC_ASYNC_READ
+        syscall
+        j       $31
+        .end    AsyncRead
+
+        .globl  AsyncWrite
+        .ent    AsyncWrite
+AsyncWrite:
+        addiu   $2, $0, SC_ASYNC_WRITE
+        syscall
+        j       $31
+        .end    AsyncWrite
+
+        .globl  Wait
+        .ent    Wait
+Wait:
+        addiu   $2, $0, SC_WAIT
+        syscall
+        j       $31
+        .end    Wait
+
+        .globl  Poll
+        .ent    Poll
+Poll:
+        addiu   $2, $0, SC_POLL
+        syscall
+        j       $31
+        .end    Poll
+
         .globl  Close
         .ent    Close
 Close:
@@ -141,6 +197,14 @@ Stats:
         j       $31
         .end    Stats
 
+        .globl  Checkpoint
+        .ent    Checkpoint
+Checkpoint:
+        addiu   $2, $0, SC_CHECKPOINT
+        syscall
+        j       $31
+        .end    Checkpoint
+
 /// Dummy function to keep gcc happy.
         .globl  __main
         .ent    __main
@@ -0,0 +1,41 @@
+/// Benchmark of system calls: many small writes and reads on a file.
+///
+/// Part of the corpus run by `userprog/bench.sh`.
+
+
+#include "syscall.h"
+
+
+#define ROUNDS  500
+#define CHUNK   16
+
+int
+main(void)
+{
+    char chunk[CHUNK];
+    OpenFileId file;
+    int i, sum = 0;
+
+    for (i = 0; i < CHUNK; i++) {
+        chunk[i] = 'a' + i;
+    }
+
+    if (Create("bench.tmp") < 0 || (file = Open("bench.tmp")) < 0) {
+        return -1;
+    }
+    for (i = 0; i < ROUNDS; i++) {
+        Write(chunk, CHUNK, file);
+    }
+    Close(file);
+
+    if ((file = Open("bench.tmp")) < 0) {
+        return -1;
+    }
+    for (i = 0; i < ROUNDS; i++) {
+        sum += Read(chunk, CHUNK, file);
+    }
+    Close(file);
+    Remove("bench.tmp");
+
+    return sum == ROUNDS * CHUNK ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+/// Check `AsyncRead`, `AsyncWrite`, `Wait` and `Poll`, on good transfers
+/// and on bad ones.  Every line should say "ok".
+
+
+#include "syscall.h"
+#include "../userprog/syscall.h" // Include fix IntelliSense
+#include "lib.h"
+
+
+#define PAGE_BYTES  128    // Bytes per page.
+
+/// Holds a page shared with the child of `Fork`, which nothing else in the
+/// program stores into.
+static char pages[2 * PAGE_BYTES];
+
+int
+main(void)
+{
+    char text[11];
+
+    Create("test_async.txt");
+    OpenFileId file = Open("test_async.txt");
+
+    int request = AsyncWrite("hello world", 11, 0, file);
+    strput(request >= 0 && Wait(request) == 11 ? "write: ok"
+                                               : "write: FAILED");
+    strput(Wait(request) == -1 ? "collected: ok" : "collected: FAILED");
+
+    // Both pending at once, collected out of order.
+    int first  = AsyncWrite("HELLO", 5, 0, file);
+    int second = AsyncWrite("WORLD", 5, 6, file);
+    strput(first >= 0 && second >= 0 && first != second
+             && Wait(second) == 5 && Wait(first) == 5
+           ? "two writes: ok" : "two writes: FAILED");
+
+    request = AsyncRead(text, 11, 0, file);
+    int result;
+    do {
+        result = Poll(request);
+    } while (result == ASYNC_PENDING);
+    strput(result == 11 && text[0] == 'H' && text[5] == ' '
+             && text[10] == 'D'
+           ? "read: ok" : "read: FAILED");
+
+    strput(AsyncRead(text, 11, 0, 42) == -1 ? "bad file: ok"
+                                            : "bad file: FAILED");
+    strput(AsyncWrite(text, 11, 0, CONSOLE_OUTPUT) == -1
+           ? "console: ok" : "console: FAILED");
+    strput(AsyncRead(text, 0, 0, file) == -1 ? "no bytes: ok"
+                                             : "no bytes: FAILED");
+    strput(AsyncRead(NULL, 11, 0, file) == -1 ? "no buffer: ok"
+                                              : "no buffer: FAILED");
+    strput(AsyncRead(text, 11, -1, file) == -1
+           ? "negative position: ok" : "negative position: FAILED");
+    strput(Wait(-1) == -1 && Poll(12345) == -1 ? "unknown transfer: ok"
+                                               : "unknown transfer: FAILED");
+
+    // A transfer out of a page shared with a child is over before the page
+    // is copied on a store; the child then goes, and its frame with it.
+    char *shared = &pages[PAGE_BYTES - (int) pages % PAGE_BYTES];
+    for (int i = 0; i < 5; i++) {
+        shared[i] = "fork!"[i];
+    }
+    SpaceId child = Fork(1);
+    if (child == FORK_CHILD) {
+        while (Open("test_async.go") == -1) {
+            Yield();
+        }
+        Exit(0);
+    }
+    request = AsyncWrite(shared, 5, 0, file);
+    shared[0] = 'F';
+    Create("test_async.go");
+    Join(child);
+    Remove("test_async.go");
+    result = Wait(request);
+    request = AsyncRead(text, 5, 0, file);
+    strput(result == 5 && Wait(request) == 5 && text[0] == 'f'
+             && text[4] == '!' && shared[0] == 'F'
+           ? "shared page: ok" : "shared page: FAILED");
+
+    // Closing the file waits for its transfers; the result is kept.
+    request = AsyncWrite("!", 1, 11, file);
+    Close(file);
+    strput(Wait(request) == 1 ? "close: ok" : "close: FAILED");
+
+    Remove("test_async.txt");
+    return 0;
+}
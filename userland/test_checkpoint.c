@@ -0,0 +1,34 @@
+/// Check `Checkpoint`.  Run it with `-ck <file>`, then resume it with
+/// `-rk <file>`; every line should say "ok".  Run without `-ck`, it only
+/// checks that no checkpoint is saved.
+
+
+#include "syscall.h"
+#include "../userprog/syscall.h" // Include fix IntelliSense
+#include "lib.h"
+
+
+int
+main(void)
+{
+    int value = 1;
+
+    // A checkpoint cannot hold open files.
+    Create("test_checkpoint.txt");
+    OpenFileId file = Open("test_checkpoint.txt");
+    strput(Checkpoint() == -1 ? "open file: ok" : "open file: FAILED");
+    Close(file);
+    Remove("test_checkpoint.txt");
+
+    int result = Checkpoint();
+    if (result == -1) {
+        strput("no checkpoint asked for");
+    } else if (result == 0) {
+        strput("saved: ok");
+        value = 2;  // Not in the checkpoint.
+    } else {
+        strput(result == 1 && value == 1 ? "resumed: ok"
+                                         : "resumed: FAILED");
+    }
+    return 0;
+}
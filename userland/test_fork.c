@@ -0,0 +1,45 @@
+/// Check `Fork`: the child goes on with a copy of the memory and none of
+/// the open files, and its exit status reaches `Join`.  Every line should
+/// say "ok".
+
+
+#include "syscall.h"
+#include "../userprog/syscall.h" // Include fix IntelliSense
+#include "lib.h"
+
+
+int
+main(void)
+{
+    int value = 1;
+
+    Create("test_fork.txt");
+    OpenFileId file = Open("test_fork.txt");
+
+    SpaceId child = Fork(1);
+    if (child == FORK_CHILD) {
+        // Stored into a page shared with the parent until now.
+        value = 2;
+        strput(Write("x", 1, file) == -1 ? "child files: ok"
+                                         : "child files: FAILED");
+        Exit(value + 5);
+    }
+    int status = Join(child);
+    strput(child >= 0 ? "fork: ok" : "fork: FAILED");
+    strput(status == 7 ? "join: ok" : "join: FAILED");
+    strput(value == 1 ? "copy: ok" : "copy: FAILED");
+    strput(Write("x", 1, file) == 1 ? "parent files: ok"
+                                    : "parent files: FAILED");
+
+    SpaceId loose = Fork(0);
+    if (loose == FORK_CHILD) {
+        Exit(0);
+    }
+    strput(loose != -1 && Join(loose) == -1 ? "unjoinable: ok"
+                                            : "unjoinable: FAILED");
+    strput(Join(-1) == -1 ? "bad join: ok" : "bad join: FAILED");
+
+    Close(file);
+    Remove("test_fork.txt");
+    return 0;
+}
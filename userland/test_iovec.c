@@ -0,0 +1,77 @@
+/// Check `ReadV` and `WriteV`, on good pieces and on bad ones.  Every line
+/// should say "ok".
+///
+/// The file is kept within the 100 bytes that `Create` gives it on the real
+/// file system.
+
+
+#include "syscall.h"
+#include "../userprog/syscall.h" // Include fix IntelliSense
+#include "lib.h"
+
+
+#define BIG_SIZE  80
+
+static int
+Same(const char *a, const char *b, int size)
+{
+    for (int i = 0; i < size; i++) {
+        if (a[i] != b[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int
+main(void)
+{
+    char big[BIG_SIZE], back[BIG_SIZE];
+    for (int i = 0; i < BIG_SIZE; i++) {
+        big[i] = 'a' + i % 26;
+    }
+
+    Create("test_iovec.txt");
+    OpenFileId file = Open("test_iovec.txt");
+
+    // An empty piece may have no buffer.
+    IoPiece out[3] = { { "abc", 3 }, { NULL, 0 }, { big, BIG_SIZE } };
+    strput(WriteV(out, 3, file) == 3 + BIG_SIZE ? "writev: ok"
+                                                : "writev: FAILED");
+    Close(file);
+
+    char head[2], tail[1];
+    file = Open("test_iovec.txt");
+    IoPiece in[3] = { { head, 2 }, { tail, 1 }, { back, BIG_SIZE } };
+    int numRead = ReadV(in, 3, file);
+    strput(numRead == 3 + BIG_SIZE && Same(head, "ab", 2)
+             && tail[0] == 'c' && Same(back, big, BIG_SIZE)
+           ? "readv: ok" : "readv: FAILED");
+
+    IoPiece many[MAX_IO_PIECES + 1];
+    for (int i = 0; i <= MAX_IO_PIECES; i++) {
+        many[i].buffer = "x";
+        many[i].size   = 1;
+    }
+    strput(WriteV(many, MAX_IO_PIECES, file) == MAX_IO_PIECES
+           ? "most pieces: ok" : "most pieces: FAILED");
+    strput(WriteV(many, MAX_IO_PIECES + 1, file) == -1
+           ? "too many pieces: ok" : "too many pieces: FAILED");
+    strput(WriteV(many, 0, file) == -1 ? "no pieces: ok"
+                                       : "no pieces: FAILED");
+    strput(WriteV(NULL, 1, file) == -1 ? "no array: ok"
+                                       : "no array: FAILED");
+
+    IoPiece bad[1] = { { NULL, 1 } };
+    strput(ReadV(bad, 1, file) == -1 ? "no buffer: ok"
+                                     : "no buffer: FAILED");
+    bad[0].buffer = tail;
+    bad[0].size   = -1;
+    strput(ReadV(bad, 1, file) == -1 ? "negative size: ok"
+                                     : "negative size: FAILED");
+    strput(ReadV(in, 1, 42) == -1 ? "bad file: ok" : "bad file: FAILED");
+
+    Close(file);
+    Remove("test_iovec.txt");
+    return 0;
+}
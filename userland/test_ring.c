@@ -0,0 +1,82 @@
+/// Check `Enter`: requests queued in a ring are carried out in order, as
+/// many as asked for, and their results come back with their tags; bad
+/// rings are refused.  Every line should say "ok".
+
+
+#include "syscall.h"
+#include "../userprog/syscall.h" // Include fix IntelliSense
+#include "lib.h"
+
+
+/// Too large for the stack.
+static Ring ring;
+
+static void
+Queue(int op, int arg0, int arg1, int arg2, int tag)
+{
+    Submission *s = &ring.submissions[ring.subTail % RING_SIZE];
+    s->op      = op;
+    s->args[0] = arg0;
+    s->args[1] = arg1;
+    s->args[2] = arg2;
+    s->tag     = tag;
+    ring.subTail++;
+}
+
+/// Take the next result, which should be that of `tag`.
+static int
+Next(int tag, int *result)
+{
+    if (ring.compHead == ring.compTail) {
+        return 0;
+    }
+    Completion *c = &ring.completions[ring.compHead % RING_SIZE];
+    ring.compHead++;
+    *result = c->result;
+    return c->tag == tag;
+}
+
+int
+main(void)
+{
+    const char *name = "test_ring.txt";
+    char text[5];
+    int create, fid, written, closed, numRead, halt;
+
+    Queue(SC_CREATE, (int) name, 0, 0, 1);
+    Queue(SC_OPEN, (int) name, 0, 0, 2);
+    strput(Enter(&ring, RING_SIZE) == 2
+             && Next(1, &create) && create == 1
+             && Next(2, &fid) && fid > CONSOLE_OUTPUT
+           ? "create and open: ok" : "create and open: FAILED");
+
+    Queue(SC_WRITE, (int) "hello", 5, fid, 3);
+    Queue(SC_CLOSE, fid, 0, 0, 4);
+    Queue(SC_OPEN, (int) name, 0, 0, 5);
+    strput(Enter(&ring, 1) == 1 && Enter(&ring, RING_SIZE) == 2
+             && Next(3, &written) && written == 5
+             && Next(4, &closed) && closed == 1
+             && Next(5, &fid) && fid > CONSOLE_OUTPUT
+           ? "count: ok" : "count: FAILED");
+
+    Queue(SC_READ, (int) text, 5, fid, 6);
+    Queue(SC_CLOSE, fid, 0, 0, 7);
+    Queue(SC_HALT, 0, 0, 0, 8);
+    strput(Enter(&ring, RING_SIZE) == 3
+             && Next(6, &numRead) && numRead == 5
+             && text[0] == 'h' && text[4] == 'o'
+             && Next(7, &closed) && closed == 1
+             && Next(8, &halt) && halt == -1
+           ? "read and close: ok" : "read and close: FAILED");
+
+    strput(Enter(&ring, RING_SIZE) == 0 ? "empty: ok" : "empty: FAILED");
+    strput(Enter(NULL, 1) == -1 ? "no ring: ok" : "no ring: FAILED");
+    strput(Enter(&ring, -1) == -1 ? "negative count: ok"
+                                  : "negative count: FAILED");
+    ring.subTail = ring.subHead + RING_SIZE + 1;
+    strput(Enter(&ring, RING_SIZE) == -1 ? "corrupt ring: ok"
+                                         : "corrupt ring: FAILED");
+
+    Remove(name);
+    return 0;
+}
@@ -8,23 +8,62 @@
 
 #include "address_space.hh"
 #include "executable.hh"
+#include "text_cache.hh"
+#include "lib/bitmap.hh"
+#include "threads/condition.hh"
 #include "threads/system.hh"
+#ifndef FILESYS_STUB
+#include "filesys/raw_file_header.hh"
+#endif
 
+#include <stdio.h>
 #include <string.h>
 
 
+#ifdef USE_TLB
+/// Address space holding every ASID, or null if it is free.
+static AddressSpace *asidOwners[NUM_ASIDS];
+
+/// Next ASID to take away from its address space, when none is free.
+static unsigned nextStolenAsid = 0;
+#endif
+
+
 /// First, set up the translation from program memory to physical memory.
-/// For now, this is really simple (1:1), since we are only uniprogramming,
-/// and we have a single unsegmented page table.
-AddressSpace::AddressSpace(OpenFile *executable_file)
+/// Without virtual memory, every page gets a frame right away, with its
+/// contents; with it, pages are loaded on demand: from the executable when
+/// first touched, and from the swap file after being written out.  Either
+/// way, pages of code already loaded for the same program are shared.
+AddressSpace::AddressSpace(OpenFile *executable_file, const char *name)
 {
-    initialized = false;
+    initialized    = false;
+    profile        = nullptr;
+    pageTable      = nullptr;
+    numPages       = 0;
+    executableFile = executable_file;
+    executable     = nullptr;
+    executableName = nullptr;
+    text           = nullptr;
+    sharedPages    = nullptr;
+#ifdef VMEM
+    swap           = nullptr;
+    inSwap         = nullptr;
+    pagingOut      = nullptr;
+    pagingLock     = nullptr;
+    pagedOut       = nullptr;
+    nextFault      = 0;
+    clusterSize    = 0;
+#endif
+#ifdef USE_TLB
+    asid           = -1;
+#endif
     if(executable_file == nullptr) {
         DEBUG('a', "No executable to run\n");
         return;
     }
 
-    Executable exe (executable_file);
+    executable = new Executable(executable_file);
+    Executable &exe = *executable;
     if (!exe.CheckMagic()) {
         DEBUG('a', "Not Nachos executable file\n");
         return;
@@ -33,92 +72,977 @@ AddressSpace::AddressSpace(OpenFile *executable_file)
     // How big is address space?
     unsigned size = exe.GetSize() + USER_STACK_SIZE;
     // We need to increase the size to leave room for the stack.
-    DEBUG('a', "Cantidad de paginas libres %d\n", bitmap->CountClear());
     numPages = DivRoundUp(size, PAGE_SIZE);
     DEBUG('a', "Cantidad de paginas asignadas al proceso %d\n", numPages);
-    
+
     size = numPages * PAGE_SIZE;
 
-    // Check we are not trying to run anything too big -- at least until we
-    // have virtual memory.
-    if(numPages > bitmap->CountClear()) {
-        DEBUG('a', "La cantidad de paginas requeridas no alcanza\n");
+    DEBUG('a', "Initializing address space, num pages %u, size %u\n",
+          numPages, size);
+
+    uint32_t codeSize = exe.GetCodeSize();
+    uint32_t initDataSize = exe.GetInitDataSize();
+    uint32_t codeAddr = exe.GetCodeAddr();
+    uint32_t initDataAddr = exe.GetInitDataAddr();
+    if ((codeSize > 0 && codeAddr + codeSize > size)
+          || (initDataSize > 0 && initDataAddr + initDataSize > size)) {
+        DEBUG('a', "Segments do not fit in the address space\n");
         return;
     }
 
-    DEBUG('a', "Initializing address space, num pages %u, size %u\n",
-          numPages, size);
+    if (name != nullptr) {
+        executableName = new char [strlen(name) + 1];
+        strcpy(executableName, name);
+        text = textCache->FindProgram(name, executable);
+    }
+
+    // With virtual memory, nothing is read until a page is touched (see
+    // `LoadPage`).
+    if (!SetUpPages(nullptr)) {
+        return;
+    }
+
+    if (profileUserPrograms) {
+        noffSymbol *symbols;
+        char *strings;
+        unsigned numSymbols = exe.ReadSymbols(&symbols, &strings);
+        profile = new Profile(size, numSymbols);
+        for (unsigned i = 0; i < numSymbols; i++) {
+            profile->SetSymbol(i, symbols[i].address,
+                               &strings[symbols[i].name]);
+        }
+        if (numSymbols != 0) {
+            delete [] symbols;
+            delete [] strings;
+        }
+        DEBUG('a', "Profiling, with %u symbols\n", numSymbols);
+    }
+
+    initialized = true;
+    DEBUG('a', "Inicializacion de address space correcta\n");
+}
+
+/// Pages of a checkpoint are saved as their flags, one word per page,
+/// followed by their contents.
+enum {
+    CHECKPOINT_READ_ONLY = 1,
+    CHECKPOINT_DIRTY     = 2,
+    CHECKPOINT_USE       = 4
+};
+
+AddressSpace::AddressSpace(FILE *checkpoint)
+{
+    ASSERT(checkpoint != nullptr);
+
+    initialized    = false;
+    profile        = nullptr;
+    pageTable      = nullptr;
+    numPages       = 0;
+    executableFile = nullptr;
+    executable     = nullptr;
+    executableName = nullptr;
+    text           = nullptr;
+    sharedPages    = nullptr;
+#ifdef VMEM
+    swap           = nullptr;
+    inSwap         = nullptr;
+    pagingOut      = nullptr;
+    pagingLock     = nullptr;
+    pagedOut       = nullptr;
+    nextFault      = 0;
+    clusterSize    = 0;
+#endif
+#ifdef USE_TLB
+    asid           = -1;
+#endif
+
+    uint32_t savedPages;
+    if (fread(&savedPages, sizeof savedPages, 1, checkpoint) != 1) {
+        DEBUG('a', "Checkpoint truncated\n");
+        return;
+    }
+#ifndef VMEM
+    if (savedPages > frameTable->CountFree()) {
+        DEBUG('a', "Not enough free frames for %u pages\n", savedPages);
+        return;
+    }
+#endif
+    uint32_t *flags = new uint32_t [savedPages];
+    char *image = new char [savedPages * PAGE_SIZE];
+    bool ok = fread(flags, sizeof *flags, savedPages, checkpoint) == savedPages
+              && fread(image, PAGE_SIZE, savedPages, checkpoint) == savedPages;
+    if (ok) {
+        numPages = savedPages;
+        ok = SetUpPages(image);
+    } else {
+        DEBUG('a', "Checkpoint truncated\n");
+    }
+    delete [] image;
+    if (!ok) {
+        delete [] flags;
+        return;
+    }
+
+    // Pages start afresh, so only whether they are read-only matters.
+    for (unsigned i = 0; i < numPages; i++) {
+        pageTable[i].readOnly = (flags[i] & CHECKPOINT_READ_ONLY) != 0;
+    }
+    delete [] flags;
+
+    if (profileUserPrograms) {
+        profile = new Profile(numPages * PAGE_SIZE, 0);
+    }
+
+    initialized = true;
+    DEBUG('a', "Address space restored, num pages %u\n", numPages);
+}
+
+/// Every page in memory is shared with the parent, read-only until either
+/// writes it, so copying costs nothing else.  With virtual memory, pages in
+/// the swap file of the parent are copied to the swap file of the new
+/// address space, and pages never loaded are loaded from the executable
+/// when touched, like those of the parent.
+AddressSpace::AddressSpace(AddressSpace *parent)
+{
+    ASSERT(parent != nullptr);
+    ASSERT(parent->initialized);
+
+    initialized    = false;
+    profile        = nullptr;
+    pageTable      = nullptr;
+    numPages       = parent->numPages;
+    executableFile = nullptr;
+    executable     = nullptr;
+    executableName = nullptr;
+    text           = parent->text;
+    sharedPages    = nullptr;
+#ifdef VMEM
+    swap           = nullptr;
+    inSwap         = nullptr;
+    pagingOut      = nullptr;
+    pagingLock     = nullptr;
+    pagedOut       = nullptr;
+    nextFault      = 0;
+    clusterSize    = 0;
+#endif
+#ifdef USE_TLB
+    asid           = -1;
+#endif
+
+    if (parent->executableName != nullptr) {
+        executableName = new char [strlen(parent->executableName) + 1];
+        strcpy(executableName, parent->executableName);
+    }
+
+#ifdef VMEM
+    // The executable is opened again; it must still hold the same program.
+    if (parent->executable != nullptr) {
+        if (executableName == nullptr
+              || (executableFile = fileSystem->Open(executableName))
+                   == nullptr) {
+            DEBUG('a', "Cannot open the executable again\n");
+            return;
+        }
+        executable = new Executable(executableFile);
+        Executable *old = parent->executable;
+        if (!executable->CheckMagic()
+              || executable->GetCodeAddr() != old->GetCodeAddr()
+              || executable->GetCodeSize() != old->GetCodeSize()
+              || executable->GetInitDataAddr() != old->GetInitDataAddr()
+              || executable->GetInitDataSize() != old->GetInitDataSize()) {
+            DEBUG('a', "Executable %s changed\n", executableName);
+            return;
+        }
+    }
+#endif
+
+    InitPageTable();
+#ifdef VMEM
+    if (!CreateSwap()) {
+        return;
+    }
+#endif
 
-    // First, set up the translation.
-    pageTable = new TranslationEntry[numPages];
+#ifdef USE_TLB
+    // The entries of the parent go, so that its pages are loaded again
+    // read-only; their bits go to its page table.
+    parent->SyncTLB((unsigned) -1);
+#endif
     for (unsigned i = 0; i < numPages; i++) {
+        TranslationEntry *entry = &parent->pageTable[i];
+#ifdef VMEM
+        // Copying may block, and meanwhile the parent may lose the page.
+        if (!entry->valid) {
+            parent->WaitPageOut(i);
+            if (parent->inSwap->Test(i)) {
+                char page[PAGE_SIZE];
+                unsigned long start = currentThread->diskTicks;
+                parent->swap->ReadAt(page, PAGE_SIZE, i * PAGE_SIZE);
+                swap->WriteAt(page, PAGE_SIZE, i * PAGE_SIZE);
+                stats->pagingTicks += currentThread->diskTicks - start;
+                inSwap->Mark(i);
+            }
+            continue;
+        }
+        // The page differs from what the new address space would load if
+        // it differs from the executable.
+        bool dirty = entry->dirty || parent->inSwap->Test(i);
+#else
+        bool dirty = entry->dirty;
+#endif
+        SharedPage *shared = parent->sharedPages[i];
+        if (shared == nullptr) {
+            shared = new SharedPage(entry->physicalPage, i);
+            parent->MapShared(i, shared, entry->dirty);
+        }
+        MapShared(i, shared, dirty);
+    }
+    machine->GetMMU()->FlushHostCache();
+
+    if (profileUserPrograms) {
+        ASSERT(parent->profile != nullptr);
+        profile = new Profile(parent->profile);
+    }
+
+    initialized = true;
+    DEBUG('a', "Address space copied, num pages %u\n", numPages);
+}
+
+bool
+AddressSpace::WriteCheckpoint(FILE *checkpoint) const
+{
+    ASSERT(checkpoint != nullptr);
+    ASSERT(initialized);
+
+    uint32_t savedPages = numPages;
+    if (fwrite(&savedPages, sizeof savedPages, 1, checkpoint) != 1) {
+        return false;
+    }
+    for (unsigned i = 0; i < numPages; i++) {
+        // Shared pages are only read-only until written.
+        bool readOnly = pageTable[i].readOnly && sharedPages[i] == nullptr;
+        uint32_t flags = (readOnly              ? CHECKPOINT_READ_ONLY : 0)
+                       | (pageTable[i].dirty    ? CHECKPOINT_DIRTY     : 0)
+                       | (pageTable[i].use      ? CHECKPOINT_USE       : 0);
+        if (fwrite(&flags, sizeof flags, 1, checkpoint) != 1) {
+            return false;
+        }
+    }
+
+    char page[PAGE_SIZE];
+    for (unsigned i = 0; i < numPages; i++) {
+        ReadPage(i, page);
+        if (fwrite(page, PAGE_SIZE, 1, checkpoint) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Deallocate an address space, freeing its frames and its swap file.
+/// Shared frames are left to the other address spaces, or to the text
+/// cache.
+AddressSpace::~AddressSpace()
+{
+    if (pageTable != nullptr) {
+        for (unsigned i = 0; i < numPages; i++) {
+            if (!pageTable[i].valid) {
+                continue;
+            }
+            if (sharedPages[i] != nullptr) {
+                UnmapShared(i);
+            } else {
+                FreeFrame(pageTable[i].physicalPage);
+            }
+        }
+    }
+#ifdef VMEM
+    // Other threads may still be writing pages out, which no other can
+    // start now that the frames are gone.
+    if (pagingOut != nullptr) {
+        for (unsigned i = 0; i < numPages; i++) {
+            WaitPageOut(i);
+        }
+    }
+#endif
+    delete [] pageTable;
+    delete [] sharedPages;
+
+#ifdef USE_TLB
+    // Its entries are left in the TLB until the ASID is taken again.
+    if (asid != -1) {
+        asidOwners[asid] = nullptr;
+    }
+#endif
+
+#ifdef VMEM
+    if (swap != nullptr) {
+        delete swap;
+#ifndef FILESYS_STUB
+        fileSystem->Remove(swapName);
+#endif
+    }
+    delete inSwap;
+    delete pagingOut;
+    delete pagedOut;
+    delete pagingLock;
+#endif
+    delete executable;
+    delete executableFile;
+    delete [] executableName;
+
+    if (machine->GetProfile() == profile) {
+        machine->SetProfile(nullptr);
+    }
+    delete profile;
+}
+
+void
+AddressSpace::InitPageTable()
+{
+    ASSERT(pageTable == nullptr);
+
+    pageTable   = new TranslationEntry[numPages];
+    sharedPages = new SharedPage * [numPages];
+    for (unsigned i = 0; i < numPages; i++) {
+        sharedPages[i]            = nullptr;
         pageTable[i].virtualPage  = i;
-        pageTable[i].physicalPage = bitmap->Find();
-        pageTable[i].valid        = true;
+        pageTable[i].physicalPage = 0;
+        pageTable[i].valid        = false;
         pageTable[i].use          = false;
         pageTable[i].dirty        = false;
         pageTable[i].readOnly     = false;
           // If the code segment was entirely on a separate page, we could
           // set its pages to be read-only.
     }
+}
 
-    char *mainMemory = machine->GetMMU()->mainMemory;
+#ifdef VMEM
 
-    // Zero out the entire address space, to zero the unitialized data
-    // segment and the stack segment.
-    for(unsigned i = 0; i < numPages ; i++)
-        memset(&mainMemory[pageTable[i].physicalPage * PAGE_SIZE], 0, PAGE_SIZE);
+bool
+AddressSpace::CreateSwap()
+{
+    static unsigned nextSwap = 0;
+    snprintf(swapName, sizeof swapName, "SWAP.%u", nextSwap++);
+    unsigned size = numPages * PAGE_SIZE;
+#ifndef FILESYS_STUB
+    if (size >= MAX_FILE_SIZE) {
+        DEBUG('a', "Swap file %s would be too big\n", swapName);
+        return false;
+    }
+#endif
+    if (!fileSystem->Create(swapName, size)) {
+        DEBUG('a', "Cannot create swap file %s\n", swapName);
+        return false;
+    }
+    swap = fileSystem->Open(swapName);
+    if (swap == nullptr) {
+        DEBUG('a', "Cannot open swap file %s\n", swapName);
+        return false;
+    }
+#ifdef FILESYS_STUB
+    // The UNIX file stays around while open; nothing is left behind even
+    // if Nachos stops without deleting the address space.
+    fileSystem->Remove(swapName);
+#endif
+    inSwap     = new Bitmap(numPages);
+    pagingOut  = new Bitmap(numPages);
+    pagingLock = new Lock("paging out");
+    pagedOut   = new Condition("paged out", pagingLock);
+    return true;
+}
 
+#endif
 
-    // Then, copy in the code and data segments into memory.
-    uint32_t codeSize = exe.GetCodeSize();
-    uint32_t initDataSize = exe.GetInitDataSize();
-    if(codeSize > 0)
-    {
-        uint32_t virtualAddr = exe.GetCodeAddr();
-        DEBUG('a', "Initializing code segment, at 0x%X, size %u\n", virtualAddr, codeSize);
-        for (uint32_t bytesRead = 0; bytesRead < codeSize; bytesRead += PAGE_SIZE)
-        {
-            uint32_t page = (virtualAddr + bytesRead) / PAGE_SIZE;
-            uint32_t offset = (virtualAddr + bytesRead) % PAGE_SIZE;
-            uint32_t readSize = min(codeSize - bytesRead, PAGE_SIZE);
-            // pageTable[page].readOnly = true;
-            exe.ReadCodeBlock(&mainMemory[(pageTable[page].physicalPage * PAGE_SIZE) + offset], readSize, bytesRead);
-        }
-    }
-
-    if(initDataSize > 0)
-    {
-        uint32_t virtualAddr = exe.GetInitDataAddr();
-        DEBUG('a', "Initializing data segment, at 0x%X, size %u\n", virtualAddr, initDataSize);
-        //Complete the unfilled part of the last page of code with initData.
-        uint32_t page = DivRoundDown(codeSize, PAGE_SIZE);
-        uint32_t offset = codeSize % PAGE_SIZE;
-        exe.ReadDataBlock(&mainMemory[(pageTable[page].physicalPage * PAGE_SIZE) + offset], PAGE_SIZE - offset, 0);
-        page++;
-
-        for (uint32_t bytesRead = PAGE_SIZE - offset; bytesRead < initDataSize; bytesRead += PAGE_SIZE)
-        {
-            page = (virtualAddr + bytesRead) / PAGE_SIZE;
-            offset = (virtualAddr + bytesRead) % PAGE_SIZE;
-            uint32_t readSize = min(initDataSize - bytesRead, PAGE_SIZE);
-            exe.ReadDataBlock(&mainMemory[(pageTable[page].physicalPage * PAGE_SIZE) + offset], readSize, bytesRead);
+bool
+AddressSpace::SetUpPages(const char *image)
+{
+    ASSERT(image != nullptr || executable != nullptr);
+
+    InitPageTable();
+#ifdef VMEM
+    if (!CreateSwap()) {
+        return false;
+    }
+    unsigned size = numPages * PAGE_SIZE;
+    if (image != nullptr) {
+        if (swap->WriteAt(image, size, 0) != (int) size) {
+            DEBUG('a', "Cannot write swap file %s\n", swapName);
+            return false;
+        }
+        for (unsigned i = 0; i < numPages; i++) {
+            inSwap->Mark(i);
         }
     }
-    initialized = true;
-    DEBUG('a', "Inicializacion de address space correcta\n");
+#else
+    MMU *mmu = machine->GetMMU();
+    for (unsigned i = 0; i < numPages; i++) {
+        if (image == nullptr && MapCachedCode(i)) {
+            continue;
+        }
+        int frame = TakeFrame(i);
+        if (frame == -1) {
+            DEBUG('a', "No free frame left for page %u\n", i);
+            return false;
+        }
+        char *memory = &mmu->mainMemory[frame * PAGE_SIZE];
+        if (image != nullptr) {
+            memcpy(memory, &image[i * PAGE_SIZE], PAGE_SIZE);
+        } else {
+            ReadExecutablePages(i, 1, memory);
+        }
+        // The frame may hold code decoded for a previous owner.
+        mmu->InvalidateFrame(frame);
+        pageTable[i].physicalPage = frame;
+        pageTable[i].valid        = true;
+        if (image == nullptr) {
+            CacheCode(i);
+        }
+    }
+#endif
+    return true;
 }
 
-/// Deallocate an address space.
-///
-/// Nothing for now!
-AddressSpace::~AddressSpace()
+int
+AddressSpace::TakeFrame(unsigned vpn)
 {
-    for(unsigned i = 0 ; i < numPages ; i++)
-        bitmap->Clear(pageTable[i].physicalPage);
-    delete [] pageTable;
+#ifdef VMEM
+    int frame = coreMap->Find(this, vpn);
+    if (frame == -1) {
+        frame = coreMap->PickVictim();
+        AddressSpace *owner = frameTable->GetOwner(frame);
+        if (owner != nullptr) {
+            owner->PageOut(frameTable->GetPage(frame));
+        } else {
+            textCache->Drop(frame);
+        }
+        coreMap->Reassign(frame, this, vpn);
+    } else {
+        coreMap->Pin(frame);
+    }
+    return frame;
+#else
+    // Failing a free frame, code that no address space runs any longer
+    // goes.
+    int frame = frameTable->Take(this, vpn);
+    if (frame == -1 && (frame = textCache->Reclaim()) != -1) {
+        frameTable->Reassign(frame, this, vpn);
+    }
+    return frame;
+#endif
+}
+
+void
+AddressSpace::FreeFrame(unsigned frame)
+{
+#ifdef VMEM
+    coreMap->Clear(frame);
+#else
+    frameTable->Free(frame);
+#endif
+}
+
+bool
+AddressSpace::IsCodePage(unsigned vpn) const
+{
+    unsigned codeStart = executable->GetCodeAddr();
+    unsigned codeEnd   = codeStart + executable->GetCodeSize();
+    return codeStart < (vpn + 1) * PAGE_SIZE && vpn * PAGE_SIZE < codeEnd;
+}
+
+bool
+AddressSpace::MapCachedCode(unsigned vpn)
+{
+    if (text == nullptr) {
+        return false;
+    }
+    SharedPage *page = textCache->Find(text, vpn);
+    if (page == nullptr) {
+        return false;
+    }
+    DEBUG('a', "Sharing page %u, in frame %u\n", vpn, page->frame);
+    MapShared(vpn, page, false);
+    return true;
+}
+
+void
+AddressSpace::CacheCode(unsigned vpn)
+{
+    // Another address space may have cached the page meanwhile; then this
+    // copy stays private.
+    if (text == nullptr || !IsCodePage(vpn)
+          || textCache->Find(text, vpn) != nullptr) {
+        return;
+    }
+    SharedPage *page = new SharedPage(pageTable[vpn].physicalPage, vpn);
+    MapShared(vpn, page, false);
+    textCache->Add(text, page);
+}
+
+void
+AddressSpace::MapShared(unsigned vpn, SharedPage *page, bool dirty)
+{
+    ASSERT(vpn < numPages);
+    ASSERT(page != nullptr && page->vpn == vpn);
+    ASSERT(sharedPages[vpn] == nullptr);
+
+    if (page->cached && page->CountMappings() == 0) {
+        textCache->Reuse(page);
+        frameTable->SetOwner(page->frame, this);
+    }
+    page->Map(this);
+    sharedPages[vpn] = page;
+
+    TranslationEntry *entry = &pageTable[vpn];
+    entry->physicalPage = page->frame;
+    entry->readOnly     = true;
+    entry->use          = false;
+    entry->dirty        = dirty;
+    entry->valid        = true;
+}
+
+void
+AddressSpace::UnmapShared(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+    ASSERT(sharedPages[vpn] != nullptr);
+
+    SharedPage *page = sharedPages[vpn];
+    sharedPages[vpn] = nullptr;
+    page->Unmap(this);
+    if (frameTable->GetOwner(page->frame) == this) {
+        frameTable->SetOwner(page->frame, page->GetMapping());
+    }
+    if (page->CountMappings() == 0) {
+        if (page->cached) {
+            textCache->Release(page);
+        } else {
+            FreeFrame(page->frame);
+            delete page;
+        }
+    }
+}
+
+bool
+AddressSpace::IsShared(unsigned vpn) const
+{
+    return vpn < numPages && sharedPages[vpn] != nullptr;
+}
+
+unsigned
+AddressSpace::GetSharedFrame(unsigned vpn) const
+{
+    ASSERT(IsShared(vpn));
+
+    return sharedPages[vpn]->frame;
+}
+
+bool
+AddressSpace::HandleReadOnly(unsigned vpn)
+{
+    if (vpn >= numPages || sharedPages[vpn] == nullptr) {
+        return false;
+    }
+
+#ifdef USE_TLB
+    SyncTLB(vpn);
+#endif
+    SharedPage *page = sharedPages[vpn];
+    MMU *mmu = machine->GetMMU();
+    TranslationEntry *entry = &pageTable[vpn];
+    if (!page->cached && page->CountMappings() == 1) {
+        // Every other address space already has a copy of its own, so this
+        // one keeps the frame.
+        DEBUG('a', "Taking page %u, in frame %u, on write\n",
+              vpn, page->frame);
+        sharedPages[vpn] = nullptr;
+        page->Unmap(this);
+        delete page;
+    } else {
+        // Nothing may take the shared frame while the copy is made.
+        unsigned from = page->frame;
+#ifdef VMEM
+        coreMap->Pin(from);
+#endif
+        int frame = TakeFrame(vpn);
+        if (frame == -1) {
+            DEBUG('a', "No free frame left to copy page %u\n", vpn);
+            return false;
+        }
+        DEBUG('a', "Copying page %u on write, from frame %u to %d\n",
+              vpn, from, frame);
+        memcpy(&mmu->mainMemory[frame * PAGE_SIZE],
+               &mmu->mainMemory[from * PAGE_SIZE], PAGE_SIZE);
+        mmu->InvalidateFrame(frame);
+#ifdef VMEM
+        coreMap->Unpin(from);
+        coreMap->Unpin(frame);
+#endif
+        UnmapShared(vpn);
+        entry->physicalPage = frame;
+    }
+    entry->readOnly = false;
+    entry->use      = true;
+    entry->dirty    = true;
+    mmu->FlushHostCache();
+#ifdef USE_TLB
+    LoadTLB(vpn);
+#endif
+    return true;
+}
+
+void
+AddressSpace::ReadPage(unsigned vpn, char *into) const
+{
+    ASSERT(vpn < numPages);
+    ASSERT(into != nullptr);
+
+#ifdef VMEM
+    if (!pageTable[vpn].valid) {
+        WaitPageOut(vpn);
+        if (inSwap->Test(vpn)) {
+            swap->ReadAt(into, PAGE_SIZE, vpn * PAGE_SIZE);
+        } else {
+            ReadExecutablePages(vpn, 1, into);
+        }
+        return;
+    }
+#endif
+    const char *mainMemory = machine->GetMMU()->mainMemory;
+    memcpy(into, &mainMemory[pageTable[vpn].physicalPage * PAGE_SIZE],
+           PAGE_SIZE);
+}
+
+void
+AddressSpace::ReadExecutablePages(unsigned vpn, unsigned count,
+                                  char *into) const
+{
+    ASSERT(vpn + count <= numPages);
+    ASSERT(into != nullptr);
+
+    memset(into, 0, count * PAGE_SIZE);
+    if (executable == nullptr) {
+        return;
+    }
+
+    // Copy whatever part of the code and data segments falls in the pages,
+    // each with a single read.
+    unsigned start = vpn * PAGE_SIZE, end = start + count * PAGE_SIZE;
+    unsigned codeStart = executable->GetCodeAddr();
+    unsigned codeEnd   = codeStart + executable->GetCodeSize();
+    if (codeStart < codeEnd && codeStart < end && start < codeEnd) {
+        unsigned from = max(start, codeStart), to = min(end, codeEnd);
+        executable->ReadCodeBlock(&into[from - start], to - from,
+                                  from - codeStart);
+    }
+    unsigned dataStart = executable->GetInitDataAddr();
+    unsigned dataEnd   = dataStart + executable->GetInitDataSize();
+    if (dataStart < dataEnd && dataStart < end && start < dataEnd) {
+        unsigned from = max(start, dataStart), to = min(end, dataEnd);
+        executable->ReadDataBlock(&into[from - start], to - from,
+                                  from - dataStart);
+    }
+}
+
+#ifdef VMEM
+
+bool
+AddressSpace::HandlePageFault(unsigned vpn)
+{
+    if (vpn >= numPages) {
+        return false;
+    }
+
+    // Loading may block on the disk, and meanwhile the page may be chosen
+    // as a victim again.
+    while (!pageTable[vpn].valid) {
+        LoadPage(vpn);
+    }
+#ifdef USE_TLB
+    LoadTLB(vpn);
+#endif
+    return true;
 }
 
+void
+AddressSpace::LoadPage(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+    ASSERT(!pageTable[vpn].valid);
+
+    WaitPageOut(vpn);
+    if (pageTable[vpn].valid) {
+        return;  // Another thread loaded it meanwhile.
+    }
+    stats->numPageFaults++;
+    bool fromSwap = inSwap->Test(vpn);
+    if (!fromSwap && MapCachedCode(vpn)) {
+        return;
+    }
+
+    // A fault right after the last cluster doubles the cluster size; any
+    // other starts over with a single page.  The frames of the pages after
+    // the faulting one are pinned out of the room shared with transfers, so
+    // that some frame is always left to replace; failing room, fewer pages
+    // are loaded.
+    clusterSize = vpn == nextFault
+                  ? min(2 * clusterSize, MAX_CLUSTER_PAGES) : 1;
+    unsigned count = 1;
+    while (count < clusterSize && vpn + count < numPages
+             && CanCluster(vpn + count, fromSwap)) {
+        count++;
+    }
+    count = 1 + coreMap->ReservePins(count - 1, false);
+    nextFault = vpn + count;
+
+    // Every frame stays pinned until its page is in it.
+    int frames[MAX_CLUSTER_PAGES];
+    for (unsigned i = 0; i < count; i++) {
+        frames[i] = TakeFrame(vpn + i);
+    }
+    DEBUG('a', "Loading pages %u to %u, from frame %d on\n",
+          vpn, vpn + count - 1, frames[0]);
+
+    // Pages never written out come from the executable, or are zero.  The
+    // whole cluster is read at once, so consecutive sectors of the file
+    // come from the track buffer of the disk.
+    char *buffer = new char [count * PAGE_SIZE];
+    unsigned long start = currentThread->diskTicks;
+    if (fromSwap) {
+        swap->ReadAt(buffer, count * PAGE_SIZE, vpn * PAGE_SIZE);
+    } else {
+        ReadExecutablePages(vpn, count, buffer);
+    }
+    stats->pagingTicks += currentThread->diskTicks - start;
+    stats->numPagesReadAhead += count - 1;
+
+    MMU *mmu = machine->GetMMU();
+    for (unsigned i = 0; i < count; i++) {
+        unsigned page = vpn + i;
+        memcpy(&mmu->mainMemory[frames[i] * PAGE_SIZE],
+               &buffer[i * PAGE_SIZE], PAGE_SIZE);
+        mmu->InvalidateFrame(frames[i]);
+
+        pageTable[page].physicalPage = frames[i];
+        pageTable[page].use          = false;
+        pageTable[page].dirty        = false;
+        pageTable[page].valid        = true;
+        if (!fromSwap) {
+            CacheCode(page);
+        }
+        coreMap->Unpin(frames[i]);
+    }
+    coreMap->ReleasePins(count - 1);
+    delete [] buffer;
+}
+
+bool
+AddressSpace::CanCluster(unsigned vpn, bool fromSwap) const
+{
+    ASSERT(vpn < numPages);
+
+    // Code that another address space loaded is mapped where it is, on its
+    // own fault.  A page still being written to the swap file would be read
+    // back before the write is over; it waits for it on its own fault.
+    return !pageTable[vpn].valid && !pagingOut->Test(vpn)
+           && inSwap->Test(vpn) == fromSwap
+           && (fromSwap || text == nullptr
+               || textCache->Find(text, vpn) == nullptr);
+}
+
+void
+AddressSpace::PageOut(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+
+    SharedPage *page = sharedPages[vpn];
+    if (page == nullptr) {
+        if (DropPage(vpn)) {
+            WritePage(vpn);
+        }
+        return;
+    }
+    if (page->cached) {
+        textCache->Remove(page);
+    }
+    // Every address space lets the page go before any write blocks, so
+    // that meanwhile none of them stores into it, copies it or frees it.
+    AddressSpace **writers = new AddressSpace * [page->CountMappings()];
+    unsigned numWriters = 0;
+    for (AddressSpace *space; (space = page->PopMapping()) != nullptr; ) {
+        space->sharedPages[vpn] = nullptr;
+        space->pageTable[vpn].readOnly = false;
+        if (space->DropPage(vpn)) {
+            writers[numWriters++] = space;
+        }
+    }
+    delete page;
+    for (unsigned i = 0; i < numWriters; i++) {
+        writers[i]->WritePage(vpn);
+    }
+    delete [] writers;
+}
+
+bool
+AddressSpace::DropPage(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+    ASSERT(pageTable[vpn].valid);
+
+#ifdef USE_TLB
+    SyncTLB(vpn);
+#endif
+    TranslationEntry *entry = &pageTable[vpn];
+    entry->valid = false;
+    machine->GetMMU()->FlushHostCache();
+    DEBUG('a', "Paging out page %u from frame %u%s\n", vpn,
+          entry->physicalPage, entry->dirty ? ", modified" : "");
+
+    if (!entry->dirty) {
+        return false;
+    }
+    // The write may block.  Meanwhile the page must be read from the swap
+    // file, and only once the write is over.
+    pagingOut->Mark(vpn);
+    inSwap->Mark(vpn);
+    entry->dirty = false;
+    return true;
+}
+
+void
+AddressSpace::WritePage(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+    ASSERT(pagingOut->Test(vpn));
+
+    const char *mainMemory = machine->GetMMU()->mainMemory;
+    unsigned long start = currentThread->diskTicks;
+    swap->WriteAt(&mainMemory[pageTable[vpn].physicalPage * PAGE_SIZE],
+                  PAGE_SIZE, vpn * PAGE_SIZE);
+    stats->pagingTicks += currentThread->diskTicks - start;
+    stats->numPageWrites++;
+
+    pagingLock->Acquire();
+    pagingOut->Clear(vpn);
+    pagedOut->Broadcast();
+    pagingLock->Release();
+}
+
+void
+AddressSpace::WaitPageOut(unsigned vpn) const
+{
+    ASSERT(vpn < numPages);
+
+    if (!pagingOut->Test(vpn)) {
+        return;
+    }
+    pagingLock->Acquire();
+    while (pagingOut->Test(vpn)) {
+        pagedOut->Wait();
+    }
+    pagingLock->Release();
+}
+
+TranslationEntry *
+AddressSpace::GetPageEntry(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+    ASSERT(pageTable[vpn].valid);
+
+    TranslationEntry *entry = &pageTable[vpn];
+#ifdef USE_TLB
+    if (asid != -1) {
+        SyncTLBEntry(machine->GetMMU()->FindTLBEntry(vpn, asid), true);
+    }
+#endif
+    return entry;
+}
+
+#endif
+
+#ifdef USE_TLB
+
+void
+AddressSpace::LoadTLB(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+    ASSERT(pageTable[vpn].valid);
+    ASSERT(asid != -1);
+
+    MMU *mmu = machine->GetMMU();
+    TranslationEntry *entry = mmu->PickTLBEntry(vpn);
+    // Entries of other address spaces already gave back their bits, when
+    // those were switched out.
+    if (entry->valid && entry->asid == (unsigned) asid) {
+        SyncTLBEntry(entry, false);
+    }
+    *entry = pageTable[vpn];
+    entry->asid = asid;
+    mmu->FlushHostCache();
+}
+
+void
+AddressSpace::SyncTLB(unsigned vpn)
+{
+    if (asid == -1) {
+        return;
+    }
+    MMU *mmu = machine->GetMMU();
+    if (vpn != (unsigned) -1) {
+        SyncTLBEntry(mmu->FindTLBEntry(vpn, asid), false);
+    } else {
+        for (unsigned i = 0; i < mmu->GetTLBSize(); i++) {
+            if (mmu->tlb[i].asid == (unsigned) asid) {
+                SyncTLBEntry(&mmu->tlb[i], false);
+            }
+        }
+    }
+    mmu->FlushHostCache();
+}
+
+void
+AddressSpace::SyncTLBEntry(TranslationEntry *entry, bool keep)
+{
+    if (entry == nullptr || !entry->valid) {
+        return;
+    }
+    TranslationEntry *page = &pageTable[entry->virtualPage];
+    page->use   = page->use   || entry->use;
+    page->dirty = page->dirty || entry->dirty;
+    if (keep) {
+        entry->use = false;
+    } else {
+        entry->valid = false;
+    }
+}
+
+void
+AddressSpace::TakeAsid()
+{
+    ASSERT(asid == -1);
+
+    for (unsigned i = 0; i < NUM_ASIDS; i++) {
+        if (asidOwners[i] == nullptr) {
+            asid = i;
+            break;
+        }
+    }
+    if (asid == -1) {
+        // Its owner is not running, so the bits of its entries are already
+        // in its page table.
+        asid = nextStolenAsid;
+        nextStolenAsid = (nextStolenAsid + 1) % NUM_ASIDS;
+        asidOwners[asid]->asid = -1;
+        DEBUG('a', "Taking ASID %d away\n", asid);
+    }
+    asidOwners[asid] = this;
+
+    // Entries left by a previous owner must go.
+    machine->GetMMU()->FlushTLB(asid);
+}
+
+#endif
+
 /// Set the initial values for the user-level register set.
 ///
 /// We write these directly into the “machine” registers, so that we can
@@ -150,24 +1074,57 @@ AddressSpace::InitRegisters()
 /// On a context switch, save any machine state, specific to this address
 /// space, that needs saving.
 ///
-/// For now, nothing!
+/// With a TLB, write back what the entries of this address space recorded;
+/// they stay there for when it runs again.
 void
 AddressSpace::SaveState()
-{}
+{
+#ifdef USE_TLB
+    if (asid == -1) {
+        return;
+    }
+    MMU *mmu = machine->GetMMU();
+    for (unsigned i = 0; i < mmu->GetTLBSize(); i++) {
+        if (mmu->tlb[i].asid == (unsigned) asid) {
+            SyncTLBEntry(&mmu->tlb[i], true);
+        }
+    }
+#endif
+}
 
 /// On a context switch, restore the machine state so that this address space
 /// can run.
 ///
-/// For now, tell the machine where to find the page table.
+/// Without a TLB, tell the machine where to find the page table; with it,
+/// tell the machine which ASID is running, taking one if needed.
 void
 AddressSpace::RestoreState()
 {
-    machine->GetMMU()->pageTable     = pageTable;
-    machine->GetMMU()->pageTableSize = numPages;
+    MMU *mmu = machine->GetMMU();
+#ifdef USE_TLB
+    if (asid == -1) {
+        TakeAsid();
+    }
+    mmu->asid = asid;
+#else
+    mmu->pageTable     = pageTable;
+    mmu->pageTableSize = numPages;
+#endif
+    mmu->FlushHostCache();  // `pageTable` may be at the address of a
+                            // deleted one.
+    machine->SetProfile(profile);
+}
+
+void
+AddressSpace::PrintProfile(const char *name) const
+{
+    if (profile != nullptr) {
+        profile->Print(name);
+    }
 }
 
 bool
 AddressSpace::IsInitialized()
 {
     return initialized;
-}
\ No newline at end of file
+}
@@ -1,9 +1,24 @@
 /// Data structures to keep track of executing user programs (address
 /// spaces).
 ///
-/// For now, we do not keep any information about address spaces.  The user
-/// level CPU state is saved and restored in the thread executing the user
-/// program (see `thread.hh`).
+/// The user level CPU state is saved and restored in the thread executing
+/// the user program (see `thread.hh`).
+///
+/// Pages of code are shared by every address space running the same program
+/// (see `text_cache.hh`), mapped read-only until written.
+///
+/// With virtual memory (`VMEM`), pages are loaded on demand: a page is
+/// brought into a frame of physical memory when it is touched, from the
+/// executable the first time (or zero-filled, outside its segments), and
+/// from the swap file of the address space after being written out.  When
+/// no frame is free, the page in a frame chosen by the replacement policy is
+/// written out (see `vmem/core_map.hh`).  Faults that sweep through the
+/// address space in order bring in clusters of the following pages as well,
+/// read from the file at once.
+///
+/// With a TLB (`USE_TLB`), the kernel also loads translations into it when
+/// they miss.  They are tagged with an identifier of the address space
+/// (ASID), so that they can stay in the TLB while others run.
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2021 Docentes de la Universidad Nacional de Rosario.
@@ -14,12 +29,28 @@
 #define NACHOS_USERPROG_ADDRESSSPACE__HH
 
 
+#include "filesys/directory_entry.hh"
 #include "filesys/file_system.hh"
+#include "machine/profile.hh"
 #include "machine/translation_entry.hh"
 
+#include <stdio.h>
+
+
+class Bitmap;
+class CachedProgram;
+class Condition;
+class Executable;
+class Lock;
+class SharedPage;
 
 const unsigned USER_STACK_SIZE = 1024;  ///< Increase this as necessary!
 
+#ifdef VMEM
+/// Most pages loaded on a single page fault.
+const unsigned MAX_CLUSTER_PAGES = 8;
+#endif
+
 
 class AddressSpace {
 public:
@@ -27,14 +58,27 @@ public:
     /// Create an address space to run a user program.
     ///
     /// The address space is initialized from an already opened file.
-    /// The program contained in the file is loaded into memory and
-    /// everything is set up so that user instructions can start to be
-    /// executed.
+    /// The program contained in the file is loaded into memory (with
+    /// virtual memory, as pages are touched) and everything is set up so
+    /// that user instructions can start to be executed.
     ///
     /// Parameters:
     /// * `executable_file` is the open file that corresponds to the
-    ///   program; it contains the object code to load into memory.
-    AddressSpace(OpenFile *executable_file);
+    ///   program; it contains the object code to load into memory.  The
+    ///   address space keeps it, and deletes it when deleted.
+    /// * `name` is the name the file was opened with; address spaces
+    ///   running files of the same name share their code.
+    AddressSpace(OpenFile *executable_file, const char *name);
+
+    /// Create an address space with the memory saved in a checkpoint, by
+    /// `WriteCheckpoint`, read from `checkpoint`.
+    AddressSpace(FILE *checkpoint);
+
+    /// Create a copy of `parent`, for a process created by `Fork`.
+    ///
+    /// Pages are copied only when written, by either address space (see
+    /// `HandleReadOnly`).
+    AddressSpace(AddressSpace *parent);
 
     /// De-allocate an address space.
     ~AddressSpace();
@@ -48,8 +92,181 @@ public:
     void RestoreState();
     bool IsInitialized();
 
+    /// Print the profile of the program, if it is being profiled (see
+    /// `profileUserPrograms`), as program `name`.
+    void PrintProfile(const char *name) const;
+
+    /// Save the pages of the address space into `checkpoint`.
+    ///
+    /// Returns false if writing fails.
+    bool WriteCheckpoint(FILE *checkpoint) const;
+
+    /// Whether page `vpn` is shared with other address spaces, or with the
+    /// text cache, and so copied when written.
+    bool IsShared(unsigned vpn) const;
+
+    /// Return the frame holding page `vpn`, which must be shared.
+    unsigned GetSharedFrame(unsigned vpn) const;
+
+    /// Make page `vpn` writable after a store to it raised a read-only
+    /// exception: if it is shared with other address spaces, give this one
+    /// its own copy of it.
+    ///
+    /// Returns false if the page is not shared, and so cannot be written,
+    /// or if no frame is left for the copy (only without virtual memory).
+    bool HandleReadOnly(unsigned vpn);
+
+#ifdef VMEM
+    /// Make page `vpn` accessible after a page fault: load it from the swap
+    /// file if it is not in memory and, if there is a TLB, load its
+    /// translation there.
+    ///
+    /// Returns false if the page is outside the address space.
+    bool HandlePageFault(unsigned vpn);
+
+    /// Take page `vpn`, which must be in memory, out of it, writing it to
+    /// the swap file if it was modified.  A shared page is taken out of
+    /// every address space mapping it.
+    void PageOut(unsigned vpn);
+
+    /// Return the page table entry of page `vpn`, which must be in memory,
+    /// so that the replacement policy can look at its `use` and `dirty`
+    /// bits, and clear `use`.
+    ///
+    /// With a TLB, the bits that it holds for the page are moved into the
+    /// entry first.
+    TranslationEntry *GetPageEntry(unsigned vpn);
+#endif
+
 private:
 
+    /// Give the address space its pages, initialized with `image`, or from
+    /// the executable if it is null: frames of physical memory or, with
+    /// virtual memory, its swap file.
+    ///
+    /// `numPages` must be set.  Returns false if that is not possible.
+    bool SetUpPages(const char *image);
+
+    /// Create the page table, with every page invalid.
+    void InitPageTable();
+
+    /// Take a frame for page `vpn`: a free one or, with virtual memory,
+    /// one freed by paging out the page in it, left pinned.
+    ///
+    /// Returns -1 if none is free (only without virtual memory).
+    int TakeFrame(unsigned vpn);
+
+    /// Free frame `frame`, of a page that is not shared.
+    void FreeFrame(unsigned frame);
+
+    /// Whether page `vpn` holds part of the code segment.
+    bool IsCodePage(unsigned vpn) const;
+
+    /// If page `vpn` is code, loaded by an address space running the same
+    /// program, map it where it is.  Returns whether it did.
+    bool MapCachedCode(unsigned vpn);
+
+    /// Share page `vpn`, just loaded from the executable, with other
+    /// address spaces running the same program, if it is code.
+    void CacheCode(unsigned vpn);
+
+    /// Map page `vpn` read-only to the frame of `page`, with its `dirty`
+    /// bit set as given.
+    void MapShared(unsigned vpn, SharedPage *page, bool dirty);
+
+    /// Stop sharing page `vpn`, leaving its page table entry alone.  The
+    /// frame is freed if no address space maps it any longer, unless the
+    /// text cache keeps it.
+    void UnmapShared(unsigned vpn);
+
+    /// Copy the contents of page `vpn` into `into`.
+    void ReadPage(unsigned vpn, char *into) const;
+
+    /// Copy the initial contents of the `count` pages from `vpn` on into
+    /// `into`: the parts of the code and initialized data segments in them,
+    /// and zeros elsewhere.
+    void ReadExecutablePages(unsigned vpn, unsigned count, char *into) const;
+
+    /// The program the address space was created from, if any.
+    OpenFile *executableFile;
+    Executable *executable;
+    char *executableName;
+
+    /// The program in the text cache, if its code is shared.
+    CachedProgram *text;
+
+    /// Shared page that every page is mapped to, or null.
+    SharedPage **sharedPages;
+
+#ifdef VMEM
+    /// Bring page `vpn` into a frame, from the swap file or the
+    /// executable, along with the pages after it if faults are sequential.
+    void LoadPage(unsigned vpn);
+
+    /// Whether page `vpn` can be loaded in the same cluster as a page read
+    /// from the swap file, if `fromSwap`, or from the executable.
+    bool CanCluster(unsigned vpn, bool fromSwap) const;
+
+    /// Take page `vpn` out of memory, as `PageOut`, but only from this
+    /// address space, and without blocking.  Return whether it was
+    /// modified; then it is marked in `pagingOut` until `WritePage` writes
+    /// it.
+    bool DropPage(unsigned vpn);
+
+    /// Write page `vpn`, dropped by `DropPage`, to the swap file.
+    void WritePage(unsigned vpn);
+
+    /// Wait until page `vpn` is not being written to the swap file.
+    void WaitPageOut(unsigned vpn) const;
+
+    /// Create the swap file, empty.
+    bool CreateSwap();
+
+    /// The swap file, holding page `i` at offset `i * PAGE_SIZE`.
+    OpenFile *swap;
+    char swapName[FILE_NAME_MAX_LEN + 1];
+
+    /// Pages written to the swap file; the others are still as in the
+    /// executable.
+    Bitmap *inSwap;
+
+    /// Pages being written to the swap file.  They are already invalid,
+    /// but must not be read back until the write ends; `pagedOut` is
+    /// signalled, under `pagingLock`, whenever one does.
+    Bitmap *pagingOut;
+    Lock *pagingLock;
+    Condition *pagedOut;
+
+    /// Page right after the last cluster loaded, and how many pages it
+    /// had: a fault there continues a sequential sweep.
+    unsigned nextFault;
+    unsigned clusterSize;
+#endif
+
+#ifdef USE_TLB
+    /// Load the translation of page `vpn` into the TLB, replacing the entry
+    /// chosen by the MMU.
+    void LoadTLB(unsigned vpn);
+
+    /// Copy the `use` and `dirty` bits of the TLB entry for page `vpn`, or
+    /// of every entry of this address space if `vpn` is -1, back into the
+    /// page table, and invalidate the entry.
+    void SyncTLB(unsigned vpn);
+
+    /// Copy the bits of `entry`, if valid, back into the page table; then
+    /// either invalidate it or, if `keep`, clear its `use` bit.
+    void SyncTLBEntry(TranslationEntry *entry, bool keep);
+
+    /// Take an address space identifier for the TLB entries of this
+    /// address space: a free one or, failing that, one of another address
+    /// space, which will take a new one when it runs again.
+    void TakeAsid();
+
+    /// Identifier tagging the TLB entries of this address space, or -1 if
+    /// it has none.
+    int asid;
+#endif
+
     /// Assume linear page table translation for now!
     TranslationEntry *pageTable;
 
@@ -59,6 +276,9 @@ private:
     ///
     bool initialized;
 
+    /// Execution counts of the program, if profiled.
+    Profile *profile;
+
 };
 
 
@@ -4,6 +4,7 @@
 
 
 #include "transfer.hh"
+#include "machine/endianness.hh"
 #include "machine/machine.hh"
 #include "threads/system.hh"
 
@@ -25,7 +26,7 @@ bool CountArgsToSave(int address, unsigned *count)
     int val;
     unsigned c = 0;
     do {
-        machine->ReadMem(address + 4 * c, 4, &val);
+        while (!machine->ReadMem(address + 4 * c, 4, &val)) {}
         c++;
     } while (c < MAX_ARG_COUNT && val != 0);
     if (c == MAX_ARG_COUNT && val != 0) {
@@ -59,7 +60,7 @@ SaveArgs(int address)
         args[i] = new char [MAX_ARG_LENGTH];
         int strAddr;
         // For each pointer, read the corresponding string.
-        machine->ReadMem(address + i * 4, 4, &strAddr);
+        while (!machine->ReadMem(address + i * 4, 4, &strAddr)) {}
         ReadStringFromUser(strAddr, args[i], MAX_ARG_LENGTH);
     }
     args[count] = nullptr;  // Write the trailing null.
@@ -77,7 +78,7 @@ WriteArgs(char **args)
     // Start writing the strings where the current SP points.  Write them in
     // reverse order (i.e. the string from the first argument will be in a
     // higher memory address than the string from the second argument).
-    int argsAddress[MAX_ARG_COUNT];
+    unsigned argsAddress[MAX_ARG_COUNT + 1];
     unsigned c;
     int sp = machine->ReadRegister(STACK_REG);
     for (c = 0; c < MAX_ARG_COUNT; c++) {
@@ -86,7 +87,8 @@ WriteArgs(char **args)
         }
         sp -= strlen(args[c]) + 1;  // Decrease SP (leave one byte for \0).
         WriteStringToUser(args[c], sp);  // Write the string there.
-        argsAddress[c] = sp;        // Save the argument's address.
+        argsAddress[c] = WordToMachine(sp);  // Save the argument's
+                                             // address.
         delete args[c];             // Free the string.
     }
     delete args;  // Free the array.
@@ -94,11 +96,9 @@ WriteArgs(char **args)
 
     sp -= sp % 4;     // Align the stack to a multiple of four.
     sp -= c * 4 + 4;  // Make room for `argv`, including the trailing null.
-    // Write each argument's address.
-    for (unsigned i = 0; i < c; i++) {
-        machine->WriteMem(sp + 4 * i, 4, argsAddress[i]);
-    }
-    machine->WriteMem(sp + 4 * c, 4, 0);  // The last is null.
+    // Write every argument's address, and the null, at once.
+    argsAddress[c] = 0;
+    WriteBufferToUser((const char *) argsAddress, sp, c * 4 + 4);
 
     machine->WriteRegister(STACK_REG, sp);
     return c;
@@ -0,0 +1,222 @@
+/// Routines to carry out file transfers asynchronously.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "async_io.hh"
+#include "transfer.hh"
+#include "threads/semaphore.hh"
+#include "threads/system.hh"
+
+
+class AsyncRequest {
+public:
+    Thread *owner;
+    OpenFile *file;
+    bool writing;
+    unsigned position;
+
+    /// Pieces of `mainMemory` holding the user buffer, in `numPages` pinned
+    /// frames, reserved with `ReservePins`.
+    IoVec iov[MAX_PINNED_PAGES];
+    unsigned count;
+    unsigned numPages;
+
+    /// Bytes transferred, once `done`.
+    int result;
+    bool done;
+
+    /// Signalled when done.
+    Semaphore *over;
+};
+
+AsyncIo::AsyncIo(unsigned numWorkers_)
+{
+    ASSERT(numWorkers_ > 0);
+
+    numWorkers = numWorkers_;
+    started    = false;
+    requests   = new Table<AsyncRequest *>;
+    queue      = new SynchList<AsyncRequest *>;
+}
+
+AsyncIo::~AsyncIo()
+{
+    for (unsigned i = 0; i < Table<AsyncRequest *>::SIZE; i++) {
+        AsyncRequest *request = requests->Get(i);
+        if (request != nullptr) {
+            delete request->over;
+            delete request;
+        }
+    }
+    delete requests;
+    delete queue;
+}
+
+int
+AsyncIo::Submit(OpenFile *file, bool writing, int userAddress,
+                unsigned size, unsigned position)
+{
+    ASSERT(file != nullptr);
+    ASSERT(userAddress != 0);
+    ASSERT(size > 0);
+
+    AsyncRequest *request = new AsyncRequest;
+    request->owner    = currentThread;
+    request->file     = file;
+    request->writing  = writing;
+    request->position = position;
+    request->count    = 0;
+    request->result   = 0;
+    request->done     = false;
+
+    // The frames are found while the program runs in its own address space;
+    // writing to the file only reads them.
+    request->numPages = ReservePins(CountUserPages(userAddress, size));
+    unsigned numPages = 0;
+    size = PinUserBuffer(userAddress, size, !writing, request->iov,
+                         &request->count, &numPages, request->numPages);
+
+    int id = requests->Add(request);
+    if (id == -1) {
+        Unpin(request, false);
+        delete request;
+        return -1;
+    }
+    request->over = new Semaphore("async request over", 0);
+
+    if (!started) {
+        started = true;
+        for (unsigned i = 0; i < numWorkers; i++) {
+            Thread *worker = new Thread("async worker", false);
+            worker->Fork(Work, this);
+        }
+    }
+    DEBUG('e', "Request %d: %s %u bytes at %u.\n",
+          id, writing ? "writing" : "reading", size, position);
+    queue->Append(request);
+    return id;
+}
+
+bool
+AsyncIo::IsPending(int id) const
+{
+    return id >= 0 && id < (int) Table<AsyncRequest *>::SIZE
+           && requests->HasKey(id)
+           && requests->Get(id)->owner == currentThread;
+}
+
+bool
+AsyncIo::IsDone(int id) const
+{
+    ASSERT(IsPending(id));
+
+    return requests->Get(id)->done;
+}
+
+int
+AsyncIo::Collect(int id)
+{
+    ASSERT(IsPending(id));
+
+    AsyncRequest *request = requests->Get(id);
+    request->over->P();
+    int result = request->result;
+    Remove(id);
+    return result;
+}
+
+void
+AsyncIo::Settle(OpenFile *file)
+{
+    for (unsigned i = 0; i < Table<AsyncRequest *>::SIZE; i++) {
+        AsyncRequest *request = requests->Get(i);
+        if (request != nullptr && request->owner == currentThread
+              && (file == nullptr || request->file == file)) {
+            // Left signalled for whoever collects it.
+            request->over->P();
+            request->over->V();
+        }
+    }
+}
+
+void
+AsyncIo::SettleFrame(unsigned frame)
+{
+    const char *start = &machine->GetMMU()->mainMemory[frame * PAGE_SIZE];
+    const char *end   = start + PAGE_SIZE;
+    for (unsigned i = 0; i < Table<AsyncRequest *>::SIZE; i++) {
+        AsyncRequest *request = requests->Get(i);
+        if (request == nullptr || request->owner != currentThread) {
+            continue;
+        }
+        for (unsigned j = 0; j < request->count; j++) {
+            const IoVec *piece = &request->iov[j];
+            if (piece->base < end && start < piece->base + piece->length) {
+                request->over->P();
+                request->over->V();
+                break;
+            }
+        }
+    }
+}
+
+void
+AsyncIo::Drop()
+{
+    for (unsigned i = 0; i < Table<AsyncRequest *>::SIZE; i++) {
+        AsyncRequest *request = requests->Get(i);
+        if (request != nullptr && request->owner == currentThread) {
+            request->over->P();
+            Remove(i);
+        }
+    }
+}
+
+void
+AsyncIo::Work(void *arg)
+{
+    AsyncIo *io = (AsyncIo *) arg;
+    for (;;) {
+        io->Serve();
+    }
+}
+
+void
+AsyncIo::Serve()
+{
+    AsyncRequest *request = queue->Pop();
+    if (request->writing) {
+        request->result = request->file->WriteAt(request->iov,
+                                                 request->count,
+                                                 request->position);
+    } else {
+        request->result = request->file->ReadAt(request->iov,
+                                                request->count,
+                                                request->position);
+    }
+    Unpin(request, !request->writing);
+    request->done = true;
+    request->over->V();
+}
+
+void
+AsyncIo::Remove(int id)
+{
+    AsyncRequest *request = requests->Remove(id);
+    ASSERT(request != nullptr && request->done);
+    DEBUG('e', "Request %d collected: %d bytes.\n", id, request->result);
+    delete request->over;
+    delete request;
+}
+
+void
+AsyncIo::Unpin(AsyncRequest *request, bool written)
+{
+    ASSERT(request != nullptr);
+
+    UnpinUserBuffer(request->iov, request->count, written);
+    ReleasePins(request->numPages);
+}
@@ -0,0 +1,110 @@
+/// Data structures to carry out file transfers asynchronously.
+///
+/// A user program submits a transfer with `AsyncRead` or `AsyncWrite` and
+/// goes on running while a kernel worker thread carries it out; later, it
+/// collects the result with `Wait` or `Poll` (see `syscall.h`).
+///
+/// Workers do not run in the address space of the program, so the frames
+/// holding the user buffer are found and pinned when the transfer is
+/// submitted (see `PinUserBuffer`), and the worker moves the data straight
+/// between them and the file; no copy is made.  The frames are let go when
+/// the transfer is over.  A transfer moves no more bytes than fit in the
+/// pages that there is room to pin (see `ReservePins`); a submission waits
+/// while other transfers take all the room.
+///
+/// The program only goes on running during a transfer if the worker blocks
+/// on the disk, that is, with the real file system.  With `FILESYS_STUB`
+/// the worker reads and writes host files without ever blocking, so the
+/// transfer is over by the next time the program is switched out, just as
+/// if it had been carried out synchronously.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_ASYNCIO__HH
+#define NACHOS_USERPROG_ASYNCIO__HH
+
+
+#include "filesys/open_file.hh"
+#include "lib/table.hh"
+#include "threads/synch_list.hh"
+
+
+class Thread;
+
+/// A transfer submitted and not collected yet.
+class AsyncRequest;
+
+class AsyncIo {
+public:
+
+    /// Initialize with no transfer pending, to be carried out by
+    /// `numWorkers` threads, started with the first transfer.
+    AsyncIo(unsigned numWorkers);
+
+    /// Forget every transfer.  Workers are left waiting.
+    ~AsyncIo();
+
+    /// Submit, on behalf of the current thread, a transfer of `size` bytes
+    /// at `position` of `file`, into the user buffer at `userAddress`, or
+    /// out of it if `writing`.
+    ///
+    /// Returns the identifier of the request, or -1 if no more requests
+    /// can be pending.
+    int Submit(OpenFile *file, bool writing, int userAddress, unsigned size,
+               unsigned position);
+
+    /// Whether `request` was submitted by the current thread and not
+    /// collected yet.
+    bool IsPending(int request) const;
+
+    /// Whether `request`, which must be pending, is over.
+    bool IsDone(int request) const;
+
+    /// Collect the result of `request`, which must be pending, waiting
+    /// until it is over: the number of bytes transferred.
+    int Collect(int request);
+
+    /// Wait until the transfers of `file` submitted by the current thread
+    /// are over, so that it can be closed; of every file if `file` is null,
+    /// so that the address space can be copied.
+    void Settle(OpenFile *file);
+
+    /// Wait until the transfers submitted by the current thread that move
+    /// data through frame `frame` are over, so that the frame can be left
+    /// to other address spaces.
+    void SettleFrame(unsigned frame);
+
+    /// Wait until the transfers submitted by the current thread are over,
+    /// and forget them, as it is finishing.
+    void Drop();
+
+private:
+
+    /// Carry out transfers forever.
+    static void Work(void *arg);
+
+    /// Take the next transfer and carry it out.
+    void Serve();
+
+    /// Forget `request`, which must be over.
+    void Remove(int request);
+
+    /// Let go the frames of `request`, telling the MMU if they were
+    /// `written`.
+    void Unpin(AsyncRequest *request, bool written);
+
+    unsigned numWorkers;
+    bool started;
+
+    /// Requests pending, by identifier.
+    Table<AsyncRequest *> *requests;
+
+    /// Requests not taken by a worker yet, in the order they were
+    /// submitted.
+    SynchList<AsyncRequest *> *queue;
+};
+
+
+#endif
@@ -0,0 +1,99 @@
+#!/bin/sh
+# Throughput benchmark of the simulator.
+#
+# Runs every program of the corpus under every build configuration, and
+# prints one tab-separated line per run, after a header line:
+#
+#     config program status seconds instructions ips syscalls
+#     syscalls_per_second faults faults_per_second
+#
+# `status` is `ok` if the machine halted, `timeout`, `missing` if the
+# kernel or the program is not built, or `failed` otherwise; the other
+# fields are then empty.  A program the kernel cannot load (with `filesys`,
+# one whose swap file would be bigger than `MAX_FILE_SIZE`) is `failed`,
+# but the kernel then waits for the console, so only at the time limit.
+# Rates are per second of host wall time; `instructions` are user ticks.
+#
+# Usage: `bench.sh [config...]`, from anywhere; by default, the
+# configurations are `userprog`, `vmem` and `filesys`.  The kernels and the
+# programs in `userland` must already be built (`make` at the top).  Set
+# `BENCH_TIMEOUT` to change the time limit of every run, in seconds.
+#
+# Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+# All rights reserved.  See `copyright.h` for copyright notice and
+# limitation of liability and disclaimer of warranty provisions.
+
+BASE_DIR=$(cd "$(dirname "$0")/.." && pwd)
+PROGRAMS="matmult sort filetest cpu_bench mem_bench syscall_bench"
+CONFIGS=${*:-"userprog vmem filesys"}
+TIMEOUT=${BENCH_TIMEOUT:-300}
+
+# The console polls standard input, and gives up at end of file; a FIFO
+# opened for reading and writing never reaches it.
+INPUT=$(mktemp -u)
+mkfifo "$INPUT" || exit 1
+trap 'rm -f "$INPUT"' EXIT
+
+# Print the field after `$2` in the line of the output `$1` starting with
+# `$3`.
+field() {
+    printf '%s\n' "$1" | awk -v key="$2" -v line="$3" '
+        index($0, line) == 1 {
+            for (i = 1; i < NF; i++) {
+                if ($i == key) { sub(",", "", $(i + 1)); print $(i + 1) }
+            }
+        }'
+}
+
+printf 'config\tprogram\tstatus\tseconds\tinstructions\tips'
+printf '\tsyscalls\tsyscalls_per_second\tfaults\tfaults_per_second\n'
+
+for config in $CONFIGS; do
+    for program in $PROGRAMS; do
+        nachos=$BASE_DIR/$config/nachos
+        executable=$BASE_DIR/userland/$program
+        if [ ! -x "$nachos" ] || [ ! -f "$executable" ]; then
+            printf '%s\t%s\tmissing\t\t\t\t\t\t\t\n' "$config" "$program"
+            continue
+        fi
+
+        # With a real file system, the program has to be copied into it.
+        case $config in
+            filesys|network) args="-f -cp $executable $program -x $program" ;;
+            *)               args="-x $executable" ;;
+        esac
+
+        start=$(date +%s%N)
+        output=$({ cd "$BASE_DIR/$config" &&
+                   timeout "$TIMEOUT" stdbuf -oL ./nachos $args \
+                       0<>"$INPUT"; } 2>&1)
+        result=$?
+        end=$(date +%s%N)
+
+        if printf '%s\n' "$output" | grep -a -q 'Unable to load file'; then
+            status=failed
+        elif [ $result -eq 124 ]; then
+            status=timeout
+        elif [ $result -ne 0 ] ||
+             ! printf '%s\n' "$output" | grep -a -q 'Machine halting!'; then
+            status=failed
+        else
+            status=ok
+        fi
+        if [ $status != ok ]; then
+            printf '%s\t%s\t%s\t\t\t\t\t\t\t\n' "$config" "$program" "$status"
+            continue
+        fi
+
+        instructions=$(field "$output" user Ticks:)
+        syscalls=$(field "$output" calls: "System calls:")
+        faults=$(field "$output" faults Paging:)
+        awk -v config="$config" -v program="$program" \
+            -v ns=$((end - start)) -v i="$instructions" \
+            -v s="$syscalls" -v f="$faults" 'BEGIN {
+                t = ns / 1e9
+                printf "%s\t%s\tok\t%.3f\t%d\t%.0f\t%d\t%.0f\t%d\t%.0f\n",
+                       config, program, t, i, i / t, s, s / t, f, f / t
+            }'
+    done
+done
@@ -0,0 +1,140 @@
+/// Routines to save a user program into a checkpoint and resume it later.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "checkpoint.hh"
+#include "address_space.hh"
+#include "threads/system.hh"
+
+#include <stdio.h>
+
+
+/// The counters of `stats` saved in a checkpoint, in order.
+static unsigned long *
+StatsCounter(unsigned i)
+{
+    unsigned long *counters[CHECKPOINT_NUM_STATS] = {
+        &stats->totalTicks,          &stats->idleTicks,
+        &stats->systemTicks,         &stats->userTicks,
+        &stats->numDiskReads,        &stats->numDiskWrites,
+        &stats->numConsoleCharsRead, &stats->numConsoleCharsWritten,
+        &stats->numPageFaults,       &stats->numPacketsSent,
+        &stats->numPacketsRecvd,     &stats->numSyscalls,
+        &stats->numPageWrites,       &stats->pagingTicks,
+        &stats->numTLBHits,          &stats->numTLBMisses
+    };
+    ASSERT(i < CHECKPOINT_NUM_STATS);
+    return counters[i];
+}
+
+/// Whether the current thread is the only one that a checkpoint would need
+/// to hold.
+static bool
+RunningAlone()
+{
+    // Other processors run threads that are not on the ready list.
+    if (multiprocessor != nullptr || scheduler->HasReadyThreads()
+          || currentThread->HasOpenFiles()) {
+        return false;
+    }
+    for (unsigned i = 0; i < MAX_SPACE; i++) {
+        if (tableThread[i].space != nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+WriteCheckpoint(const char *path, const int *registers)
+{
+    ASSERT(path != nullptr);
+    ASSERT(registers != nullptr);
+    ASSERT(currentThread->space != nullptr);
+
+    if (!RunningAlone()) {
+        DEBUG('e', "Cannot checkpoint: other threads, processors or open "
+                   "files.\n");
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == nullptr) {
+        DEBUG('e', "Cannot create checkpoint `%s`.\n", path);
+        return false;
+    }
+
+    checkpointHeader header;
+    header.magic        = CHECKPOINT_MAGIC;
+    header.pageSize     = PAGE_SIZE;
+    header.numRegisters = NUM_TOTAL_REGS;
+    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
+        header.registers[i] = registers[i];
+    }
+    for (unsigned i = 0; i < CHECKPOINT_NUM_STATS; i++) {
+        header.stats[i] = *StatsCounter(i);
+    }
+    // The system call asking for the checkpoint is not accounted for yet.
+    header.stats[0] += USER_TICK;  // `totalTicks`.
+    header.stats[3] += USER_TICK;  // `userTicks`.
+
+    bool ok = fwrite(&header, sizeof header, 1, file) == 1
+              && currentThread->space->WriteCheckpoint(file);
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        DEBUG('e', "Cannot write checkpoint `%s`.\n", path);
+        remove(path);
+        return false;
+    }
+    DEBUG('e', "Checkpoint written to `%s`.\n", path);
+    return true;
+}
+
+void
+StartFromCheckpoint(const char *path)
+{
+    ASSERT(path != nullptr);
+
+    FILE *file = fopen(path, "rb");
+    if (file == nullptr) {
+        printf("Unable to open checkpoint %s\n", path);
+        return;
+    }
+
+    checkpointHeader header;
+    if (fread(&header, sizeof header, 1, file) != 1
+          || header.magic != CHECKPOINT_MAGIC
+          || header.pageSize != PAGE_SIZE
+          || header.numRegisters != NUM_TOTAL_REGS) {
+        printf("%s is not a checkpoint of this machine\n", path);
+        fclose(file);
+        return;
+    }
+
+    AddressSpace *space = new AddressSpace(file);
+    fclose(file);
+    if (!space->IsInitialized()) {
+        printf("Unable to restore the memory saved in %s\n", path);
+        delete space;
+        return;
+    }
+    currentThread->space = space;
+    numUserPrograms++;
+
+    for (unsigned i = 0; i < CHECKPOINT_NUM_STATS; i++) {
+        if (i != 0) {
+            *StatsCounter(i) = header.stats[i];
+        }
+    }
+    interrupt->SetTime(header.stats[0]);  // `totalTicks`.
+
+    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
+        machine->WriteRegister(i, header.registers[i]);
+    }
+    space->RestoreState();  // Load page table register.
+    machine->Run();  // Resume the user program.
+    ASSERT(false);   // `machine->Run` never returns.
+}
@@ -0,0 +1,62 @@
+/// Checkpoints of a running user program.
+///
+/// A program calls the system call `Checkpoint` once it has done whatever
+/// work is common to many runs; if Nachos was given `-ck <file>`, the state
+/// of the machine is saved into that UNIX file.  Later, `nachos -rk <file>`
+/// resumes the program from there, instead of running it from the start.
+/// `Checkpoint` returns 0 to the program that saved the checkpoint, and 1
+/// to a program resumed from it.
+///
+/// The checkpoint holds the user registers, the address space, and the
+/// statistics, so that simulated time continues where it was.  It does not
+/// hold kernel threads, which live on host stacks, so the program must be
+/// running alone: no other thread may be ready to run, no joinable child
+/// may exist, and no file besides the console may be open.  Devices are
+/// set up again by the resuming Nachos, so it must be given the same flags;
+/// in particular, the file system is whatever the disk holds then.
+///
+/// The file consists of a `checkpointHeader`, followed by the page flags and
+/// the pages of the address space, one after the other.  Everything is in
+/// host byte order.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_CHECKPOINT__HH
+#define NACHOS_USERPROG_CHECKPOINT__HH
+
+
+#include "machine/machine.hh"
+
+#include <stdint.h>
+
+
+const uint32_t CHECKPOINT_MAGIC = 0x4E434B33;  // `NCK3`.
+
+/// Counters of `Statistics` saved in a checkpoint.
+const unsigned CHECKPOINT_NUM_STATS = 16;
+
+struct checkpointHeader {
+    uint32_t magic;
+    uint32_t pageSize;      ///< Must match `PAGE_SIZE`.
+    uint32_t numRegisters;  ///< Must match `NUM_TOTAL_REGS`.
+    int32_t  registers[NUM_TOTAL_REGS];
+    uint64_t stats[CHECKPOINT_NUM_STATS];
+};
+
+/// Save the state of the current user program into the UNIX file `path`,
+/// from the system call `Checkpoint`, so that, when resumed, its registers
+/// are `registers`.
+///
+/// Returns false if the program is not running alone or the file cannot be
+/// written.
+bool WriteCheckpoint(const char *path, const int *registers);
+
+/// Resume the user program saved in the UNIX file `path`.
+///
+/// Only returns if the checkpoint cannot be read.
+void StartFromCheckpoint(const char *path);
+
+
+#endif
@@ -133,8 +133,9 @@ CommandDump(char **args, void *extra)
         return DCM::RUN_RESULT_STAY;
     }
 
-    int rv = fwrite(machine->GetMMU()->mainMemory, 1, MEMORY_SIZE, f);
-    if (rv != MEMORY_SIZE) {
+    unsigned size = machine->GetMMU()->GetMemorySize();
+    unsigned rv = fwrite(machine->GetMMU()->mainMemory, 1, size, f);
+    if (rv != size) {
         fprintf(stderr, "ERROR: write to file `%s` did not succeed.\n",
                 path);
         return DCM::RUN_RESULT_STAY;
@@ -157,6 +158,13 @@ CommandFlags(char **args, void *extra)
     return DCM::RUN_RESULT_STAY;
 }
 
+static DCM::RunResult
+CommandFrames(char **args, void *extra)
+{
+    frameTable->Print();
+    return DCM::RUN_RESULT_STAY;
+}
+
 static DCM::RunResult
 CommandHelp(char **args, void *extra)
 {
@@ -166,6 +174,8 @@ Debugger commands:\n\
     dump <path>             Dump the simulated machine's main memory into\n\
                             a file.\n\
     flags, f                Show current flags for debug output.\n\
+    frames                  Show the frames of physical memory in use,\n\
+                            and the pages they hold.\n\
     help, h, ?              Show this help message.\n\
     print, p <address>...   Print bytes from memory.  The addresses are\n\
                             taken as virtual by default; one can specify\n\
@@ -213,7 +223,7 @@ CommandPrint(char **args, void *extra)
             }
 
         } else if (strcmp(end, "@p") == 0) {
-            if (address >= MEMORY_SIZE) {
+            if (address >= machine->GetMMU()->GetMemorySize()) {
                 fprintf(stderr, "ERROR: address %u is too big.\n", address);
                 return DCM::RUN_RESULT_STAY;
             }
@@ -307,6 +317,7 @@ Debugger::Debugger()
     manager.AddCommand("dump",     &CommandDump,     nullptr);
     manager.AddCommand("flags",    &CommandFlags,    nullptr);
     manager.AddCommand("f",        &CommandFlags,    nullptr);
+    manager.AddCommand("frames",   &CommandFrames,   nullptr);
     manager.AddCommand("help",     &CommandHelp,     nullptr);
     manager.AddCommand("h",        &CommandHelp,     nullptr);
     manager.AddCommand("?",        &CommandHelp,     nullptr);
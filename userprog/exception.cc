@@ -29,8 +29,12 @@
 #include "threads/thread.hh"
 #include "synch_console.hh"
 #include "address_space.hh"
+#include "checkpoint.hh"
 #include "args.hh"
+#include "async_io.hh"
+#include "machine/endianness.hh"
 #include <stdio.h>
+#include <string.h>
 
 static void
 IncrementPC()
@@ -64,6 +68,450 @@ void newThread(void *arg)
     machine->Run(); // Jump to the user progam.
 }
 
+/// Run a process created by `Fork`, from the registers in `arg`.
+static void
+ForkedProcess(void *arg)
+{
+    int *registers = (int *) arg;
+    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
+        machine->WriteRegister(i, registers[i]);
+    }
+    delete [] registers;
+    currentThread->space->RestoreState();  // Load page table register.
+    machine->Run();
+}
+
+/// End the process running in the current thread with `status`, as the
+/// `Exit` system call does.
+static void
+EndProcess(int status)
+{
+    currentThread->space->PrintProfile(currentThread->GetName());
+    // The console keeps interrupts pending, so the machine would idle
+    // forever once no program is left.
+    if (--numUserPrograms == 0) {
+        DEBUG('e', "Shutdown, after the last user program exited.\n");
+        interrupt->Halt();
+    }
+    asyncIo->Drop();
+    currentThread->Finish(status);
+}
+
+/// Record `child`, with its address space, among the processes that can be
+/// joined, if `joinable`.
+///
+/// Return its identifier, or -1 if no more processes can be joined.
+static int
+AddProcess(Thread *child, bool joinable)
+{
+    if (!joinable) {
+        return MAX_SPACE + 1;
+    }
+    for (int i = 0; i < MAX_SPACE; i++) {
+        if (tableThread[i].space == nullptr) {
+            tableThread[i].space  = (SpaceId *) child->space;
+            tableThread[i].thread = child;
+            DEBUG('e', "Success in tableThread for %s\n", child->GetName());
+            return i;
+        }
+    }
+    return -1;
+}
+
+/// A buffer in user memory, named by `Read` or `Write`, or by one piece of
+/// `ReadV` or `WriteV`.
+struct UserBuffer {
+    int address;
+    int size;
+};
+
+/// Copy the `count` pieces at `address` that a `ReadV` or `WriteV` names
+/// into `buffers`.
+///
+/// Return false if they cannot be transferred.
+static bool
+ReadUserBuffers(int address, int count, UserBuffer *buffers)
+{
+    if (address == 0 || count <= 0 || count > MAX_IO_PIECES) {
+        DEBUG('e', "Error: %d pieces at 0x%X.\n", count, address);
+        return false;
+    }
+
+    unsigned words[2 * MAX_IO_PIECES];
+    ReadBufferFromUser(address, (char *) words, 2 * count * sizeof *words);
+    for (int i = 0; i < count; i++) {
+        buffers[i].address = WordToHost(words[2 * i]);
+        buffers[i].size    = WordToHost(words[2 * i + 1]);
+        if (buffers[i].size < 0
+              || (buffers[i].size > 0 && buffers[i].address == 0)) {
+            DEBUG('e', "Error: piece %d is %d bytes at 0x%X.\n",
+                  i, buffers[i].size, buffers[i].address);
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Return the number of pages, at most `MAX_PINNED_PAGES`, that the
+/// `count` buffers of `buffers` not transferred yet fall in, from `offset`
+/// bytes into buffer `next` on.
+static unsigned
+CountUserBufferPages(const UserBuffer *buffers, unsigned count,
+                     unsigned next, int offset)
+{
+    unsigned numPages = 0;
+    for (; next < count && numPages < MAX_PINNED_PAGES; next++) {
+        if (buffers[next].size > offset) {
+            numPages += CountUserPages(buffers[next].address + offset,
+                                       buffers[next].size - offset);
+        }
+        offset = 0;
+    }
+    return min(numPages, MAX_PINNED_PAGES);
+}
+
+/// Pin the start of the `count` buffers of `buffers` not transferred yet,
+/// from `*offset` bytes into buffer `*next` on, into the pieces of `iov`
+/// (see `PinUserBuffer`), and move past them.  At most `maxPages` pages
+/// are pinned.
+///
+/// Return the number of bytes pinned.
+static int
+PinUserBuffers(const UserBuffer *buffers, unsigned count, bool writing,
+               unsigned *next, int *offset, IoVec *iov, unsigned *numPieces,
+               unsigned maxPages)
+{
+    int numBytes = 0;
+    unsigned numPages = 0;
+    *numPieces = 0;
+    while (*next < count) {
+        const UserBuffer *buffer = &buffers[*next];
+        if (buffer->size > *offset) {
+            int n = PinUserBuffer(buffer->address + *offset,
+                                  buffer->size - *offset, writing,
+                                  iov, numPieces, &numPages, maxPages);
+            numBytes += n;
+            *offset  += n;
+            if (*offset < buffer->size) {
+                break;  // No more pages can be pinned.
+            }
+        }
+        (*next)++;
+        *offset = 0;
+    }
+    return numBytes;
+}
+
+/// Read from `file`, or from the console if null, into the `count` buffers
+/// of `buffers` in turn.  Return the number of bytes read.
+static int
+ReadIntoUser(OpenFile *file, const UserBuffer *buffers, unsigned count)
+{
+    int bytesRead = 0;
+    if (file == nullptr) {
+        // Characters arrive one at a time; rather than keep frames pinned
+        // while waiting for them, take a page at a time.  A line is
+        // returned as soon as it ends.
+        char chunk[PAGE_SIZE];
+        for (unsigned i = 0; i < count; i++) {
+            for (int done = 0; done < buffers[i].size; ) {
+                int n = synchConsole->Read(chunk,
+                          min(buffers[i].size - done, (int) PAGE_SIZE));
+                WriteBufferToUser(chunk, buffers[i].address + done, n);
+                done      += n;
+                bytesRead += n;
+                if (chunk[n - 1] == '\n') {
+                    return bytesRead;
+                }
+            }
+        }
+        return bytesRead;
+    }
+
+    // Read straight into the frames of the buffers, a few pages at a time.
+    unsigned next = 0;
+    int offset = 0;
+    unsigned numPages;
+    while ((numPages = CountUserBufferPages(buffers, count, next, offset))
+             > 0) {
+        IoVec iov[MAX_PINNED_PAGES];
+        unsigned numPieces;
+        numPages = ReservePins(numPages);
+        int wanted = PinUserBuffers(buffers, count, true, &next, &offset,
+                                    iov, &numPieces, numPages);
+        int n = file->Read(iov, numPieces);
+        UnpinUserBuffer(iov, numPieces, true);
+        ReleasePins(numPages);
+        bytesRead += n;
+        if (n < wanted) {
+            break;
+        }
+    }
+    return bytesRead;
+}
+
+/// Write the `count` buffers of `buffers` in turn to `file`, or to the
+/// console if null.  Return the number of bytes written.
+static int
+WriteFromUser(OpenFile *file, const UserBuffer *buffers, unsigned count)
+{
+    // Write straight from the frames of the buffers, a few pages at a time.
+    int bytesWritten = 0;
+    unsigned next = 0;
+    int offset = 0;
+    unsigned numPages;
+    while ((numPages = CountUserBufferPages(buffers, count, next, offset))
+             > 0) {
+        IoVec iov[MAX_PINNED_PAGES];
+        unsigned numPieces;
+        numPages = ReservePins(numPages);
+        int wanted = PinUserBuffers(buffers, count, false, &next, &offset,
+                                    iov, &numPieces, numPages);
+        int n = wanted;
+        if (file == nullptr) {
+            synchConsole->Write(iov, numPieces);
+        } else {
+            n = file->Write(iov, numPieces);
+        }
+        UnpinUserBuffer(iov, numPieces, false);
+        ReleasePins(numPages);
+        bytesWritten += n;
+        if (n < wanted) {
+            break;
+        }
+    }
+    return bytesWritten;
+}
+
+/// Read the name of a file from user memory at `filenameAddr` into
+/// `filename`.
+///
+/// Return false if it cannot be read.
+static bool
+ReadFilename(int filenameAddr, char filename[FILE_NAME_MAX_LEN + 1])
+{
+    if (filenameAddr == 0) {
+        DEBUG('e', "Error: address to filename string is null.\n");
+        return false;
+    }
+    if (!ReadStringFromUser(filenameAddr,
+                            filename, FILE_NAME_MAX_LEN + 1)) {
+        DEBUG('e', "Error: filename string too long (maximum is %u bytes).\n",
+              FILE_NAME_MAX_LEN);
+        return false;
+    }
+    return true;
+}
+
+/// File system calls, whether trapped or submitted through a ring (see
+/// `DoEnter`).  Each takes the arguments of the system call and returns its
+/// result.
+
+static int
+DoCreate(int filenameAddr)
+{
+    char filename[FILE_NAME_MAX_LEN + 1];
+    if (!ReadFilename(filenameAddr, filename)) {
+        return -1;
+    }
+    DEBUG('e', "`Create` requested for file `%s`.\n", filename);
+    if(!fileSystem->Create(filename, 100)){
+        DEBUG('e', "Error: Failed to create the file: %s\n", filename);
+        return -1;
+    }
+    return 1;
+}
+
+static int
+DoOpen(int filenameAddr)
+{
+    char filename[FILE_NAME_MAX_LEN + 1];
+    if (!ReadFilename(filenameAddr, filename)) {
+        return -1;
+    }
+    DEBUG('e', "`Open` EXCEPTION requested for filename %s.\n", filename);
+
+    OpenFile *file = fileSystem->Open(filename);
+    if (file == nullptr)
+    {
+        DEBUG('e', "File not found\n");
+        return -1;
+    }
+
+    OpenFileId fid = currentThread->AddOpenFile(file);
+    if(fid == -1)
+    {
+        DEBUG('e', "Error: no space left to open file.\n");
+        delete file;
+        return -1;
+    }
+    return fid;
+}
+
+static int
+DoClose(OpenFileId fid)
+{
+    if (fid < 0)
+    {
+        DEBUG('e',"File id not valid\n");
+        return -1;
+    }
+    DEBUG('e', "`Close` requested for id %u.\n", fid);
+    OpenFile *file = currentThread->GetOpenFileByFileId(fid);
+    if (file != nullptr) {
+        asyncIo->Settle(file);
+    }
+    if(!currentThread->DeleteOpenFile(fid))
+    {
+        DEBUG('e', "`Close` requested for id failed %u.\n", fid);
+        return -1;
+    }
+    return 1;
+}
+
+static int
+DoRead(int bufferDest, int size, OpenFileId fid)
+{
+    if(size <= 0)
+    {
+        DEBUG('e', "Size read equal to 0\n");
+        return 0;
+    }
+    if (bufferDest == 0) {
+        DEBUG('e', "Error: address to buffer is null.\n");
+        return -1;
+    }
+
+    DEBUG('e', "`Read` requested for id %u.\n", fid);
+
+    OpenFile *file = nullptr;
+    if (fid != CONSOLE_INPUT) {
+        file = currentThread->GetOpenFileByFileId(fid);
+        if(!file)
+        {
+            DEBUG('e', "Error: File is not open.\n.");
+            return -1;
+        }
+    }
+    UserBuffer buffer = { bufferDest, size };
+    return ReadIntoUser(file, &buffer, 1);
+}
+
+static int
+DoWrite(int bufferSource, int size, OpenFileId fid)
+{
+    if(size <= 0)
+    {
+        DEBUG('e', "Size read equal to 0\n");
+        return 0;
+    }
+    if (bufferSource == 0) {
+        DEBUG('e', "Error: address to buffer is null.\n");
+        return -1;
+    }
+
+    DEBUG('e', "`Write` requested for id %u.\n", fid);
+
+    OpenFile *file = nullptr;
+    if (fid == CONSOLE_OUTPUT ) {
+        DEBUG('e', "Console output\n");
+    }
+    else {
+        file = currentThread->GetOpenFileByFileId(fid);
+        if(!file)
+        {
+            DEBUG('e', "Error: File is not open.\n.");
+            return -1;
+        }
+    }
+    UserBuffer buffer = { bufferSource, size };
+    return WriteFromUser(file, &buffer, 1);
+}
+
+/// Carry out up to `count` of the requests queued in the ring at `ringAddr`,
+/// in order, posting their results as completions.
+///
+/// Return how many were carried out, or -1 if the ring is not valid.
+static int
+DoEnter(int ringAddr, int count)
+{
+    if (ringAddr == 0 || count < 0) {
+        DEBUG('e', "Error: ring at 0x%X, %d requests.\n", ringAddr, count);
+        return -1;
+    }
+
+    // The indices, in the order they are laid out in `Ring`.
+    enum { SUB_HEAD, SUB_TAIL, COMP_HEAD, COMP_TAIL, NUM_INDICES };
+    const int subAddr  = ringAddr + NUM_INDICES * 4;
+    const int compAddr = subAddr + RING_SIZE * sizeof (Submission);
+    unsigned indices[NUM_INDICES];
+    ReadBufferFromUser(ringAddr, (char *) indices, sizeof indices);
+    for (unsigned i = 0; i < NUM_INDICES; i++) {
+        indices[i] = WordToHost(indices[i]);
+    }
+    if (indices[SUB_TAIL] - indices[SUB_HEAD] > RING_SIZE
+          || indices[COMP_TAIL] - indices[COMP_HEAD] > RING_SIZE) {
+        DEBUG('e', "Error: ring at 0x%X is corrupt.\n", ringAddr);
+        return -1;
+    }
+
+    int done = 0;
+    while (done < count && indices[SUB_HEAD] != indices[SUB_TAIL]
+             && indices[COMP_TAIL] - indices[COMP_HEAD] < RING_SIZE) {
+        unsigned words[sizeof (Submission) / 4];
+        ReadBufferFromUser(subAddr + indices[SUB_HEAD] % RING_SIZE
+                                     * sizeof (Submission),
+                           (char *) words, sizeof words);
+        int op = WordToHost(words[0]);
+        int args[3];
+        for (unsigned i = 0; i < 3; i++) {
+            args[i] = WordToHost(words[1 + i]);
+        }
+        DEBUG('e', "Request %u from ring at 0x%X: system call %d.\n",
+              indices[SUB_HEAD], ringAddr, op);
+
+        int result;
+        switch (op) {
+            case SC_CREATE:
+                result = DoCreate(args[0]);
+                break;
+            case SC_OPEN:
+                result = DoOpen(args[0]);
+                break;
+            case SC_CLOSE:
+                result = DoClose(args[0]);
+                break;
+            case SC_READ:
+                result = DoRead(args[0], args[1], args[2]);
+                break;
+            case SC_WRITE:
+                result = DoWrite(args[0], args[1], args[2]);
+                break;
+            default:
+                DEBUG('e', "Error: system call %d cannot be queued.\n", op);
+                result = -1;
+        }
+
+        unsigned completion[2] = { words[4], WordToMachine(result) };
+        WriteBufferToUser((const char *) completion,
+                          compAddr + indices[COMP_TAIL] % RING_SIZE
+                                     * sizeof (Completion),
+                          sizeof completion);
+        indices[SUB_HEAD]++;
+        indices[COMP_TAIL]++;
+        done++;
+    }
+
+    for (unsigned i = 0; i < NUM_INDICES; i++) {
+        indices[i] = WordToMachine(indices[i]);
+    }
+    WriteBufferToUser((const char *) &indices[SUB_HEAD],
+                      ringAddr + SUB_HEAD * 4, 4);
+    WriteBufferToUser((const char *) &indices[COMP_TAIL],
+                      ringAddr + COMP_TAIL * 4, 4);
+    return done;
+}
+
 /// Do some default behavior for an unexpected exception.
 ///
 /// NOTE: this function is meant specifically for unexpected exceptions.  If
@@ -95,10 +543,14 @@ StartProcess(const char *filename)
         return;
     }
 
-    AddressSpace *space = new AddressSpace(executable);
+    AddressSpace *space = new AddressSpace(executable, filename);
+    if (!space->IsInitialized()) {
+        printf("Unable to load file %s\n", filename);
+        delete space;
+        return;
+    }
     currentThread->space = space;
-
-    delete executable;
+    numUserPrograms++;
 
     space->InitRegisters();  // Set the initial register values.
     space->RestoreState();   // Load page table register.
@@ -132,35 +584,13 @@ SyscallHandler(ExceptionType _et)
 
         case SC_HALT:
             DEBUG('e', "Shutdown, initiated by user program.\n");
+            currentThread->space->PrintProfile(currentThread->GetName());
             interrupt->Halt();
             break;
 
-        case SC_CREATE: {
-            int filenameAddr = machine->ReadRegister(4);
-            if (filenameAddr == 0) {
-                machine->WriteRegister(2, -1);
-                DEBUG('e', "Error: address to filename string is null.\n");
-                break;
-            }
-
-            char filename[FILE_NAME_MAX_LEN + 1];
-            if (!ReadStringFromUser(filenameAddr,
-                                    filename, sizeof filename)) {
-                machine->WriteRegister(2, -1);
-                DEBUG('e', "Error: filename string too long (maximum is %u bytes).\n",
-                      FILE_NAME_MAX_LEN);
-                break;
-            }
-            DEBUG('e', "`Create` requested for file `%s`.\n", filename);
-            if(!fileSystem->Create(filename, 100)){
-                machine->WriteRegister(2, -1);
-                DEBUG('e', "Error: Failed to create the file: %s\n", filename);
-                break;
-            }
-
-            machine->WriteRegister(2, 1);
+        case SC_CREATE:
+            machine->WriteRegister(2, DoCreate(machine->ReadRegister(4)));
             break;
-        }
 
         case SC_EXEC: {
             DEBUG('e', "Request for Starting process\n");
@@ -202,40 +632,21 @@ SyscallHandler(ExceptionType _et)
                 break;
             }
 
-            AddressSpace *newSpace = new AddressSpace(file);
+            AddressSpace *newSpace = new AddressSpace(file, filename);
             if(!newSpace->IsInitialized())
             {
+                delete newSpace;
                 machine->WriteRegister(2, -1);
                 DEBUG('e', "Error al inicializar el address space\n");
                 break;
             }
             child->space = newSpace;
-            int i = 0;
-            
-            if(joinable)
+            int i = AddProcess(child, joinable);
+            if (i == -1)
             {
-                for (; i < MAX_SPACE; i++)
-                {
-                    if (tableThread[i].space == nullptr)
-                    {
-                        tableThread[i].space = (SpaceId *)newSpace;
-                        tableThread[i].thread = child;
-                        DEBUG('e', "Success in tableThread for %s\n", filename);
-                        break;
-                    }
-                }
-                
-                if(tableThread[i].space != (SpaceId*)newSpace)
-                {
-                    delete newSpace;
-                    delete child; 
-                    machine->WriteRegister(2, -1);
-                    break;                   
-                }
-            }
-            else
-            {
-                i = MAX_SPACE + 1;
+                delete child;  // Along with its address space.
+                machine->WriteRegister(2, -1);
+                break;
             }
 
             char **args = nullptr;
@@ -244,15 +655,58 @@ SyscallHandler(ExceptionType _et)
                 args = SaveArgs(argvAddr);
             }
             child->Fork(newThread, args);
+            numUserPrograms++;
 
             DEBUG('e', "Success in Exec for %s\n", filename);
 
-            delete file;
-
             machine->WriteRegister(2, i);
             break;
         }
 
+        case SC_FORK: {
+            DEBUG('e', "Request for forking process\n");
+            int joinable = machine->ReadRegister(4);
+
+            // Pending transfers move data straight into the frames about to
+            // be shared with the child.
+            asyncIo->Settle(nullptr);
+            AddressSpace *newSpace = new AddressSpace(currentThread->space);
+            if (!newSpace->IsInitialized()) {
+                delete newSpace;
+                machine->WriteRegister(2, -1);
+                DEBUG('e', "Error: cannot copy the address space.\n");
+                break;
+            }
+            const char *name = currentThread->GetName();
+            char *threadName = new char [strlen(name) + 1];
+            strcpy(threadName, name);
+            Thread *child = new Thread(threadName, joinable, 2);
+            child->space = newSpace;
+            int id = AddProcess(child, joinable);
+            if (id == -1) {
+                delete child;  // Along with its address space.
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            // The child goes on after the system call, seeing `FORK_CHILD`
+            // as its result.
+            int *registers = new int [NUM_TOTAL_REGS];
+            for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
+                registers[i] = machine->ReadRegister(i);
+            }
+            registers[2]           = FORK_CHILD;
+            registers[PREV_PC_REG] = registers[PC_REG];
+            registers[PC_REG]      = registers[NEXT_PC_REG];
+            registers[NEXT_PC_REG] = registers[PC_REG] + 4;
+            child->Fork(ForkedProcess, registers);
+            numUserPrograms++;
+
+            DEBUG('e', "Success in Fork of %s\n", name);
+            machine->WriteRegister(2, id);
+            break;
+        }
+
         case SC_JOIN: {
             int index = machine->ReadRegister(4);
             if(index < MAX_SPACE && index >= 0) {
@@ -270,20 +724,15 @@ SyscallHandler(ExceptionType _et)
             break;
         }
 
-        case SC_REMOVE: {
-            int filenameAddr = machine->ReadRegister(4);
-            if (filenameAddr == 0) {
-                machine->WriteRegister(2, -1);
-                DEBUG('e', "Error: address to filename string is null.\n");
-                break;
-            }
+        case SC_YIELD:
+            DEBUG('e', "`Yield` requested.\n");
+            currentThread->Yield();
+            break;
 
+        case SC_REMOVE: {
             char filename[FILE_NAME_MAX_LEN + 1];
-            if (!ReadStringFromUser(filenameAddr,
-                                    filename, sizeof filename)) {
+            if (!ReadFilename(machine->ReadRegister(4), filename)) {
                 machine->WriteRegister(2, -1);
-                DEBUG('e', "Error: filename string too long (maximum is %u bytes).\n",
-                      FILE_NAME_MAX_LEN);
                 break;
             }
             DEBUG('e', "`Remove` requested for file `%s`.\n", filename);
@@ -298,143 +747,133 @@ SyscallHandler(ExceptionType _et)
             break;
         }
 
-        case SC_EXIT: {
-            currentThread->Finish(machine->ReadRegister(4));
+        case SC_EXIT:
+            EndProcess(machine->ReadRegister(4));
             break;
-        }
 
-        case SC_OPEN: {
-            int filenameAddr = machine->ReadRegister(4);
-            if (filenameAddr == 0)
-            {
-                machine->WriteRegister(2, -1);
-                DEBUG('e', "Error: address to filename string is null.\n");
-                break;
-            }
+        case SC_OPEN:
+            machine->WriteRegister(2, DoOpen(machine->ReadRegister(4)));
+            break;
 
-            char filename[FILE_NAME_MAX_LEN + 1];
-            if (!ReadStringFromUser(filenameAddr,
-                                    filename, sizeof filename))
-            {
-                machine->WriteRegister(2, -1);
-                DEBUG('e', "Error: filename string too long (maximum is %u bytes).\n",
-                      FILE_NAME_MAX_LEN);
-                break;
-            }
-            DEBUG('e', "`Open` EXCEPTION requested for filename %s.\n", filename);
+        case SC_CLOSE:
+            machine->WriteRegister(2, DoClose(machine->ReadRegister(4)));
+            break;
 
-            OpenFile *file = fileSystem->Open(filename);
+        case SC_READ:
+            machine->WriteRegister(2, DoRead(machine->ReadRegister(4),
+                                             machine->ReadRegister(5),
+                                             machine->ReadRegister(6)));
+            break;
 
-            if (file == nullptr)
-            {
-                machine->WriteRegister(2, -1);
-                DEBUG('e', "File not found\n");
-                break;
-            }
+        case SC_WRITE:
+            machine->WriteRegister(2, DoWrite(machine->ReadRegister(4),
+                                              machine->ReadRegister(5),
+                                              machine->ReadRegister(6)));
+            break;
 
-            OpenFileId fid = currentThread->AddOpenFile(file);
+        case SC_READV: {
+            int piecesAddr = machine->ReadRegister(4);
+            int count = machine->ReadRegister(5);
+            OpenFileId fid = machine->ReadRegister(6);
+            DEBUG('e', "`ReadV` requested for id %u, %d pieces.\n",
+                  fid, count);
 
-            if(fid == -1)
-            {
+            UserBuffer buffers[MAX_IO_PIECES];
+            if (!ReadUserBuffers(piecesAddr, count, buffers)) {
                 machine->WriteRegister(2, -1);
-                DEBUG('e', "Error: no space left to open file.\n");
-                break;
-            }
-
-            machine->WriteRegister(2, fid);
-            break;
-        }
-
-        case SC_CLOSE: {
-            OpenFileId fid = machine->ReadRegister(4);
-            if (fid < 0)
-            {
-                DEBUG('e',"File id not valid\n");
                 break;
             }
-            DEBUG('e', "`Close` requested for id %u.\n", fid);
-            bool success = currentThread->DeleteOpenFile(fid);
-            if(!success)
-            {
-                DEBUG('e', "`Close` requested for id failed %u.\n", fid);
-                machine->WriteRegister(2, -1);
-                break;
+            OpenFile *file = nullptr;
+            if (fid != CONSOLE_INPUT) {
+                file = currentThread->GetOpenFileByFileId(fid);
+                if (file == nullptr) {
+                    DEBUG('e', "Error: File is not open.\n");
+                    machine->WriteRegister(2, -1);
+                    break;
+                }
             }
-            machine->WriteRegister(2, 1);
+            machine->WriteRegister(2, ReadIntoUser(file, buffers, count));
             break;
         }
 
-        case SC_READ: {
-            int bufferDest = machine->ReadRegister(4);
-            int size = machine->ReadRegister(5);
-            int fid = machine->ReadRegister(6);
+        case SC_WRITEV: {
+            int piecesAddr = machine->ReadRegister(4);
+            int count = machine->ReadRegister(5);
+            OpenFileId fid = machine->ReadRegister(6);
+            DEBUG('e', "`WriteV` requested for id %u, %d pieces.\n",
+                  fid, count);
 
-            if(size <= 0)
-            {
-                DEBUG('e', "Size read equal to 0\n");
+            UserBuffer buffers[MAX_IO_PIECES];
+            if (!ReadUserBuffers(piecesAddr, count, buffers)) {
+                machine->WriteRegister(2, -1);
                 break;
             }
-
-            DEBUG('e', "`Read` requested for id %u.\n", fid);
-
-            char dest[size];
-            int bytesRead = 0;
-            if (fid == CONSOLE_INPUT) {
-                synchConsole->Read(dest, size);
-                WriteStringToUser(dest, bufferDest);
-                bytesRead = size;
-            }
-            else {
-                OpenFile* file = currentThread->GetOpenFileByFileId(fid);
-                if(!file)
-                {
-                    DEBUG('e', "Error: File is not open.\n.");
+            OpenFile *file = nullptr;
+            if (fid != CONSOLE_OUTPUT) {
+                file = currentThread->GetOpenFileByFileId(fid);
+                if (file == nullptr) {
+                    DEBUG('e', "Error: File is not open.\n");
                     machine->WriteRegister(2, -1);
                     break;
                 }
-                bytesRead = file->Read(dest, (unsigned)size);
-                if(bytesRead > 0)
-                {
-                    WriteBufferToUser(dest, bufferDest, bytesRead);
-                }
             }
-            machine->WriteRegister(2, bytesRead);
+            machine->WriteRegister(2, WriteFromUser(file, buffers, count));
             break;
         }
 
-        case SC_WRITE:
-        {
-            int bufferSource = machine->ReadRegister(4);
+        case SC_ENTER:
+            machine->WriteRegister(2, DoEnter(machine->ReadRegister(4),
+                                              machine->ReadRegister(5)));
+            break;
+
+        case SC_ASYNC_READ:
+        case SC_ASYNC_WRITE: {
+            bool writing = scid == SC_ASYNC_WRITE;
+            int bufferAddr = machine->ReadRegister(4);
             int size = machine->ReadRegister(5);
-            OpenFileId fid = machine->ReadRegister(6);
-            if(size <= 0)
-            {
-                DEBUG('e', "Size read equal to 0\n");
+            int position = machine->ReadRegister(6);
+            OpenFileId fid = machine->ReadRegister(7);
+            DEBUG('e', "`%s` requested for id %u, %d bytes at %d.\n",
+                  writing ? "AsyncWrite" : "AsyncRead", fid, size, position);
+
+            if (bufferAddr == 0 || size <= 0 || position < 0) {
+                DEBUG('e', "Error: %d bytes at 0x%X, position %d.\n",
+                      size, bufferAddr, position);
+                machine->WriteRegister(2, -1);
                 break;
             }
-            
-            DEBUG('e', "`Write` requested for id %u.\n", fid);
-
-            char out[size + 1];
-            ReadBufferFromUser(bufferSource, out, size);
-            if (fid == CONSOLE_OUTPUT ) {
-                DEBUG('e', "Console output\n");
-                synchConsole->Write(out, size);
+            OpenFile *file = fid > CONSOLE_OUTPUT
+                             ? currentThread->GetOpenFileByFileId(fid)
+                             : nullptr;
+            if (file == nullptr) {
+                DEBUG('e', "Error: File is not open.\n");
+                machine->WriteRegister(2, -1);
+                break;
             }
-            else {
-                OpenFile* file = currentThread->GetOpenFileByFileId(fid);
-                if(!file)
-                {
-                    DEBUG('e', "Error: File is not open.\n.");
-                    machine->WriteRegister(2, -1);
-                    break;
-                }
+            int request = asyncIo->Submit(file, writing, bufferAddr,
+                                          min(size, MAX_ASYNC_SIZE),
+                                          position);
+            if (request == -1) {
+                DEBUG('e', "Error: too many transfers pending.\n");
+            }
+            machine->WriteRegister(2, request);
+            break;
+        }
 
-                out[size] = '\0';
+        case SC_WAIT:
+        case SC_POLL: {
+            int request = machine->ReadRegister(4);
+            DEBUG('e', "`%s` requested for transfer %d.\n",
+                  scid == SC_WAIT ? "Wait" : "Poll", request);
 
-                file->Write(out, (unsigned)size);
+            if (!asyncIo->IsPending(request)) {
+                DEBUG('e', "Error: no transfer %d pending.\n", request);
+                machine->WriteRegister(2, -1);
+            } else if (scid == SC_POLL && !asyncIo->IsDone(request)) {
+                machine->WriteRegister(2, ASYNC_PENDING);
+            } else {
+                machine->WriteRegister(2, asyncIo->Collect(request));
             }
-            machine->WriteRegister(2, 1);
             break;
         }
 
@@ -445,6 +884,29 @@ SyscallHandler(ExceptionType _et)
             break;
         }
 
+        case SC_CHECKPOINT: {
+            if (checkpointPath == nullptr) {
+                DEBUG('e', "`Checkpoint` requested, but no file given.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            // Save the program as it will be after the system call, with
+            // the result seen when resuming.
+            int registers[NUM_TOTAL_REGS];
+            for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
+                registers[i] = machine->ReadRegister(i);
+            }
+            registers[2]           = 1;
+            registers[PREV_PC_REG] = registers[PC_REG];
+            registers[PC_REG]      = registers[NEXT_PC_REG];
+            registers[NEXT_PC_REG] = registers[PC_REG] + 4;
+
+            bool ok = WriteCheckpoint(checkpointPath, registers);
+            machine->WriteRegister(2, ok ? 0 : -1);
+            break;
+        }
+
         default:
             fprintf(stderr, "Unexpected system call: id %d.\n", scid);
             ASSERT(false);
@@ -455,6 +917,47 @@ SyscallHandler(ExceptionType _et)
 }
 
 
+#ifdef VMEM
+
+/// Handle a page fault, or a TLB miss, by loading the page that holds the
+/// faulting address.  The faulting instruction is then run again.
+static void
+PageFaultHandler(ExceptionType et)
+{
+    unsigned vaddr = machine->ReadRegister(BAD_VADDR_REG);
+    if (!currentThread->space->HandlePageFault(vaddr / PAGE_SIZE)) {
+        DefaultHandler(et);
+    }
+}
+
+#endif
+
+/// Handle a store to a read-only page.  If the page is shared, the address
+/// space gets its own copy, and the faulting instruction is run again.
+///
+/// Without virtual memory there may be no frame left for the copy; then
+/// only the process that stored goes, as if it had called `Exit(-1)`.
+static void
+ReadOnlyHandler(ExceptionType et)
+{
+    unsigned vpn = machine->ReadRegister(BAD_VADDR_REG) / PAGE_SIZE;
+    AddressSpace *space = currentThread->space;
+    if (!space->IsShared(vpn)) {
+        DefaultHandler(et);
+        return;
+    }
+    // Pending transfers may still be moving data out of the shared frame,
+    // which is about to be left to the other address spaces.  Meanwhile the
+    // page may be paged out; then it is loaded again, writable, on the next
+    // try.
+    asyncIo->SettleFrame(space->GetSharedFrame(vpn));
+    if (space->IsShared(vpn) && !space->HandleReadOnly(vpn)) {
+        DEBUG('a', "Out of memory copying page %u of %s, ending it\n",
+              vpn, currentThread->GetName());
+        EndProcess(-1);
+    }
+}
+
 /// By default, only system calls have their own handler.  All other
 /// exception types are assigned the default handler.
 void
@@ -462,8 +965,12 @@ SetExceptionHandlers()
 {
     machine->SetHandler(NO_EXCEPTION,            &DefaultHandler);
     machine->SetHandler(SYSCALL_EXCEPTION,       &SyscallHandler);
+#ifdef VMEM
+    machine->SetHandler(PAGE_FAULT_EXCEPTION,    &PageFaultHandler);
+#else
     machine->SetHandler(PAGE_FAULT_EXCEPTION,    &DefaultHandler);
-    machine->SetHandler(READ_ONLY_EXCEPTION,     &DefaultHandler);
+#endif
+    machine->SetHandler(READ_ONLY_EXCEPTION,     &ReadOnlyHandler);
     machine->SetHandler(BUS_ERROR_EXCEPTION,     &DefaultHandler);
     machine->SetHandler(ADDRESS_ERROR_EXCEPTION, &DefaultHandler);
     machine->SetHandler(OVERFLOW_EXCEPTION,      &DefaultHandler);
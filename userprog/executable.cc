@@ -7,6 +7,8 @@
 #include "executable.hh"
 #include "machine/endianness.hh"
 
+#include <stdlib.h>
+
 
 /// Do little endian to big endian conversion on the bytes in the object file
 /// header, in case the file was generated on a little endian machine, and we
@@ -101,3 +103,80 @@ Executable::ReadDataBlock(char *dest, uint32_t size, uint32_t offset)
 
     return file->ReadAt(dest, size, header.initData.inFileAddr + offset);
 }
+
+static int
+CompareSymbols(const void *a, const void *b)
+{
+    const noffSymbol *x = (const noffSymbol *) a;
+    const noffSymbol *y = (const noffSymbol *) b;
+    return x->address < y->address ? -1 : x->address > y->address;
+}
+
+unsigned
+Executable::ReadSymbols(noffSymbol **symbols, char **strings)
+{
+    ASSERT(symbols != nullptr);
+    ASSERT(strings != nullptr);
+
+    // The table starts right after the last segment in the file.
+    uint32_t position = sizeof header;
+    if (header.code.size != 0) {
+        position = header.code.inFileAddr + header.code.size;
+    }
+    if (header.initData.size != 0
+          && header.initData.inFileAddr + header.initData.size > position) {
+        position = header.initData.inFileAddr + header.initData.size;
+    }
+
+    noffSymbolsHeader h;
+    if (file->ReadAt((char *) &h, sizeof h, position) != sizeof h) {
+        return 0;
+    }
+    // Swap as `CheckMagic` does for the header.
+    bool swap = h.magic != NOFF_SYMBOLS_MAGIC
+                && WordToHost(h.magic) == NOFF_SYMBOLS_MAGIC;
+    if (swap) {
+        h.magic       = WordToHost(h.magic);
+        h.numSymbols  = WordToHost(h.numSymbols);
+        h.stringsSize = WordToHost(h.stringsSize);
+    }
+    if (h.magic != NOFF_SYMBOLS_MAGIC || h.numSymbols == 0
+          || h.numSymbols > file->Length() || h.stringsSize > file->Length()) {
+        return 0;
+    }
+    position += sizeof h;
+
+    noffSymbol *s = new noffSymbol [h.numSymbols];
+    char *names = new char [h.stringsSize + 1];
+    unsigned symbolsSize = h.numSymbols * sizeof *s;
+    if (file->ReadAt((char *) s, symbolsSize, position) != (int) symbolsSize
+          || file->ReadAt(names, h.stringsSize, position + symbolsSize)
+             != (int) h.stringsSize) {
+        delete [] s;
+        delete [] names;
+        return 0;
+    }
+    names[h.stringsSize] = '\0';
+    uint32_t codeStart = header.code.virtualAddr;
+    uint32_t codeEnd   = codeStart + header.code.size;
+    for (unsigned i = 0; i < h.numSymbols; i++) {
+        if (swap) {
+            s[i].address = WordToHost(s[i].address);
+            s[i].name    = WordToHost(s[i].name);
+        }
+        // A table naming procedures outside the code, or names outside
+        // the strings, was not written by `coff2noff`: ignore all of it.
+        if (s[i].address < codeStart || s[i].address > codeEnd
+              || s[i].name >= h.stringsSize) {
+            delete [] s;
+            delete [] names;
+            return 0;
+        }
+    }
+    // Nothing in the format promises any order.
+    qsort(s, h.numSymbols, sizeof *s, CompareSymbols);
+
+    *symbols = s;
+    *strings = names;
+    return h.numSymbols;
+}
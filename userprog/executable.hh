@@ -62,6 +62,15 @@ public:
     int ReadCodeBlock(char *dest, uint32_t size, uint32_t offset);
     int ReadDataBlock(char *dest, uint32_t size, uint32_t offset);
 
+    /// Read the table of procedures that `coff2noff` stores after the
+    /// segments, if the program was linked with symbols.
+    ///
+    /// Return the number of symbols, or 0 if the table is missing or not
+    /// valid.  If it is not zero, `*symbols` and `*strings` are set to
+    /// arrays allocated with `new[]`, holding the symbols sorted by address
+    /// and their names.  The caller must delete them.
+    unsigned ReadSymbols(noffSymbol **symbols, char **strings);
+
 private:
     OpenFile *file;
     noffHeader header;
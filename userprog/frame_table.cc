@@ -0,0 +1,193 @@
+/// Routines to allocate the frames of physical memory.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "frame_table.hh"
+#include "lib/utility.hh"
+
+#include <stdio.h>
+
+
+FrameTable::FrameTable(unsigned numFrames_)
+{
+    numFrames  = numFrames_;
+    freeFrames = new unsigned [numFrames];
+    inUse      = new bool [numFrames];
+    owners     = new AddressSpace * [numFrames];
+    pages      = new unsigned [numFrames];
+    previous   = new int [numFrames];
+    next       = new int [numFrames];
+    // Frames are taken from the lowest, at first.
+    for (unsigned i = 0; i < numFrames; i++) {
+        freeFrames[i] = numFrames - 1 - i;
+        inUse[i]      = false;
+        owners[i]     = nullptr;
+        pages[i]      = 0;
+        previous[i]   = -1;
+        next[i]       = -1;
+    }
+    numFree = numFrames;
+    oldest  = -1;
+    newest  = -1;
+}
+
+FrameTable::~FrameTable()
+{
+    delete [] freeFrames;
+    delete [] inUse;
+    delete [] owners;
+    delete [] pages;
+    delete [] previous;
+    delete [] next;
+}
+
+int
+FrameTable::Take(AddressSpace *space, unsigned vpn)
+{
+    if (numFree == 0) {
+        return -1;
+    }
+    unsigned frame = freeFrames[--numFree];
+    ASSERT(!inUse[frame]);
+    inUse[frame]  = true;
+    owners[frame] = space;
+    pages[frame]  = vpn;
+    Append(frame);
+    return frame;
+}
+
+void
+FrameTable::Free(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+    ASSERT(inUse[frame]);
+
+    Unlink(frame);
+    inUse[frame]  = false;
+    owners[frame] = nullptr;
+    freeFrames[numFree++] = frame;
+}
+
+void
+FrameTable::Reassign(unsigned frame, AddressSpace *space, unsigned vpn)
+{
+    ASSERT(frame < numFrames);
+    ASSERT(inUse[frame]);
+
+    owners[frame] = space;
+    pages[frame]  = vpn;
+    Renew(frame);
+}
+
+void
+FrameTable::SetOwner(unsigned frame, AddressSpace *space)
+{
+    ASSERT(frame < numFrames);
+    ASSERT(inUse[frame]);
+
+    owners[frame] = space;
+}
+
+void
+FrameTable::Renew(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+    ASSERT(inUse[frame]);
+
+    Unlink(frame);
+    Append(frame);
+}
+
+bool
+FrameTable::IsInUse(unsigned frame) const
+{
+    ASSERT(frame < numFrames);
+    return inUse[frame];
+}
+
+AddressSpace *
+FrameTable::GetOwner(unsigned frame) const
+{
+    ASSERT(frame < numFrames);
+    return owners[frame];
+}
+
+unsigned
+FrameTable::GetPage(unsigned frame) const
+{
+    ASSERT(frame < numFrames);
+    return pages[frame];
+}
+
+int
+FrameTable::GetOldest() const
+{
+    return oldest;
+}
+
+int
+FrameTable::GetNext(unsigned frame) const
+{
+    ASSERT(frame < numFrames);
+    ASSERT(inUse[frame]);
+    return next[frame];
+}
+
+unsigned
+FrameTable::GetNumFrames() const
+{
+    return numFrames;
+}
+
+unsigned
+FrameTable::CountFree() const
+{
+    return numFree;
+}
+
+void
+FrameTable::Print() const
+{
+    printf("Frames free: %u of %u\n", numFree, numFrames);
+    for (int frame = oldest; frame != -1; frame = next[frame]) {
+        if (owners[frame] != nullptr) {
+            printf("\t%d: page %u of address space %p\n",
+                   frame, pages[frame], (void *) owners[frame]);
+        } else {
+            printf("\t%d: page %u, cached code\n", frame, pages[frame]);
+        }
+    }
+}
+
+void
+FrameTable::Append(unsigned frame)
+{
+    previous[frame] = newest;
+    next[frame]     = -1;
+    if (newest != -1) {
+        next[newest] = frame;
+    } else {
+        oldest = frame;
+    }
+    newest = frame;
+}
+
+void
+FrameTable::Unlink(unsigned frame)
+{
+    if (previous[frame] != -1) {
+        next[previous[frame]] = next[frame];
+    } else {
+        oldest = next[frame];
+    }
+    if (next[frame] != -1) {
+        previous[next[frame]] = previous[frame];
+    } else {
+        newest = previous[frame];
+    }
+    previous[frame] = -1;
+    next[frame]     = -1;
+}
@@ -0,0 +1,94 @@
+/// Data structures to allocate the frames of physical memory.
+///
+/// Free frames are kept in a stack, so that taking and freeing one, as
+/// well as counting them, take constant time.  Every frame in use records
+/// the page it holds: a virtual page of the address space owning it, or a
+/// page of code that only the text cache keeps (see `text_cache.hh`).
+/// Frames in use are also linked in the order they were taken, for the
+/// replacement policies (see `vmem/core_map.hh`).
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_FRAMETABLE__HH
+#define NACHOS_USERPROG_FRAMETABLE__HH
+
+
+class AddressSpace;
+
+class FrameTable {
+public:
+
+    /// Initialize a table of `numFrames` free frames.
+    FrameTable(unsigned numFrames);
+
+    ~FrameTable();
+
+    /// Take a free frame for page `vpn` of `space`.
+    ///
+    /// Returns -1 if no frame is free.
+    int Take(AddressSpace *space, unsigned vpn);
+
+    /// Free frame `frame`, which must be in use.
+    void Free(unsigned frame);
+
+    /// Give frame `frame`, which must be in use, to page `vpn` of `space`,
+    /// as if it had just been taken.
+    void Reassign(unsigned frame, AddressSpace *space, unsigned vpn);
+
+    /// Let `space` own frame `frame`, which holds the same page for it as
+    /// for the current owner; `space` is null if the text cache owns it.
+    void SetOwner(unsigned frame, AddressSpace *space);
+
+    /// Move frame `frame`, which must be in use, behind every other, as if
+    /// it had just been taken.
+    void Renew(unsigned frame);
+
+    bool IsInUse(unsigned frame) const;
+    AddressSpace *GetOwner(unsigned frame) const;
+    unsigned GetPage(unsigned frame) const;
+
+    /// Return the frame in use taken longest ago, or -1 if none is.
+    int GetOldest() const;
+
+    /// Return the frame in use taken right after `frame`, or -1 if none
+    /// was.
+    int GetNext(unsigned frame) const;
+
+    unsigned GetNumFrames() const;
+
+    /// Return the number of free frames.
+    unsigned CountFree() const;
+
+    /// Print the frames in use, and their pages, for debugging.
+    void Print() const;
+
+private:
+
+    /// Link `frame` behind every frame in use, or unlink it.
+    void Append(unsigned frame);
+    void Unlink(unsigned frame);
+
+    unsigned numFrames;
+
+    /// Free frames, the next one to take last.
+    unsigned *freeFrames;
+    unsigned numFree;
+
+    bool *inUse;
+
+    /// Page held by every frame in use.
+    AddressSpace **owners;
+    unsigned *pages;
+
+    /// Frames in use, in the order they were taken, linked in both ways;
+    /// -1 ends them.
+    int *previous;
+    int *next;
+    int oldest;
+    int newest;
+};
+
+
+#endif
@@ -0,0 +1,247 @@
+/// Routines to run user programs on several simulated processors.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "multiprocessor.hh"
+#include "threads/system.hh"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+class KernelLock {
+public:
+    /// The lock is taken in turn: a processor draws the next ticket, and
+    /// holds the lock while `serving` equals it.
+    unsigned long nextTicket;
+    unsigned long serving;
+
+    /// Processors waiting for the lock, and idle ones.
+    unsigned waiting;
+    unsigned idle;
+
+    /// Changes whenever a thread becomes ready.
+    unsigned long wakeups;
+
+    /// Whether the machine is halting.
+    bool halting;
+
+    /// Guards the fields above; `changed` is notified whenever they
+    /// change.
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+/// Index of the processor simulated by the running host thread.
+static thread_local unsigned current = 0;
+
+/// Wait for the turn of the current processor and take `lock`; `guard`
+/// must hold its mutex.
+static void
+Acquire(KernelLock *lock, std::unique_lock<std::mutex> &guard)
+{
+    unsigned long ticket = lock->nextTicket++;
+    lock->waiting++;
+    lock->changed.notify_all();
+    lock->changed.wait(guard, [&] { return lock->serving == ticket; });
+    lock->waiting--;
+}
+
+/// Let go of `lock`; `guard` must hold its mutex.
+static void
+Release(KernelLock *lock, std::unique_lock<std::mutex> &guard)
+{
+    lock->serving++;
+    lock->changed.notify_all();
+}
+
+/// Run by the idle thread of every processor, with interrupts disabled for
+/// good.
+static void
+IdleLoop(void *dummy)
+{
+    interrupt->SetLevel(INT_OFF);
+    for (;;) {
+        Thread *next = scheduler->FindNextToRun();
+        if (next != nullptr) {
+            scheduler->Run(next);
+        } else {
+            multiprocessor->Idle();
+        }
+    }
+}
+
+Multiprocessor::Multiprocessor(unsigned count_, Machine *boot)
+{
+    ASSERT(count_ > 1 && count_ <= MAX_PROCESSORS);
+    ASSERT(boot != nullptr);
+
+    count = count_;
+    for (unsigned i = 0; i < count; i++) {
+        processors[i].machine = i == 0 ? boot : new Machine(boot);
+        processors[i].thread  = nullptr;
+        processors[i].idle    = nullptr;
+        processors[i].level   = INT_OFF;
+        processors[i].status  = SYSTEM_MODE;
+    }
+
+    lock = new KernelLock;
+    lock->nextTicket = 1;  // The first one is taken by the boot processor.
+    lock->serving    = 0;
+    lock->waiting    = 0;
+    lock->idle       = 0;
+    lock->wakeups    = 0;
+    lock->halting    = false;
+}
+
+void
+Multiprocessor::Start()
+{
+    ASSERT(current == 0);
+
+    for (unsigned i = 0; i < count; i++) {
+        Thread *t = new Thread("idle", false, 0);
+        t->processor = i;
+        processors[i].idle = t;
+        t->Fork(IdleLoop, nullptr);
+    }
+
+    // The host thread of every other processor starts in a thread of its
+    // own that finishes at once, leaving the processor to the ready threads
+    // or its idle thread.
+    for (unsigned i = 1; i < count; i++) {
+        processors[i].thread = new Thread("boot", false);
+        std::thread(RunProcessor, this, i).detach();
+    }
+}
+
+void
+Multiprocessor::RunProcessor(Multiprocessor *self, unsigned index)
+{
+    current = index;
+    self->Lock();
+    currentThread->Finish(0);
+    // Not reached.
+}
+
+unsigned
+Multiprocessor::GetCount() const
+{
+    return count;
+}
+
+unsigned
+Multiprocessor::GetCurrent() const
+{
+    return current;
+}
+
+bool
+Multiprocessor::MayRun(const Thread *thread) const
+{
+    ASSERT(thread != nullptr);
+    return thread->processor == -1 || thread->processor == (int) current;
+}
+
+Thread *
+Multiprocessor::GetIdleThread()
+{
+    return processors[current].idle;
+}
+
+void
+Multiprocessor::RestoreState()
+{
+    Processor *p = &processors[current];
+    currentThread = p->thread;
+    machine       = p->machine;
+    interrupt->SetState(p->level, p->status);
+}
+
+void
+Multiprocessor::SaveState()
+{
+    Processor *p = &processors[current];
+    p->thread = currentThread;
+    p->level  = interrupt->GetLevel();
+    p->status = interrupt->GetStatus();
+}
+
+void
+Multiprocessor::Lock()
+{
+    std::unique_lock<std::mutex> guard(lock->mutex);
+    Acquire(lock, guard);
+    RestoreState();
+}
+
+unsigned long
+Multiprocessor::Unlock(unsigned long budget)
+{
+    std::unique_lock<std::mutex> guard(lock->mutex);
+    SaveState();
+    Release(lock, guard);
+    return budget < PROCESSOR_SLICE ? budget : PROCESSOR_SLICE;
+}
+
+void
+Multiprocessor::Preempt()
+{
+    std::unique_lock<std::mutex> guard(lock->mutex);
+    if (lock->waiting > 0) {
+        SaveState();
+        Release(lock, guard);
+        Acquire(lock, guard);
+        RestoreState();
+    }
+}
+
+void
+Multiprocessor::Wake()
+{
+    std::unique_lock<std::mutex> guard(lock->mutex);
+    if (lock->idle > 0) {
+        lock->wakeups++;
+        lock->changed.notify_all();
+    }
+}
+
+void
+Multiprocessor::Idle()
+{
+    std::unique_lock<std::mutex> guard(lock->mutex);
+
+    // Nothing else can make a thread ready but an interrupt.
+    if (lock->waiting == 0 && lock->idle == count - 1) {
+        guard.unlock();
+        interrupt->Idle();
+        return;
+    }
+
+    DEBUG('t', "Processor %u idle\n", current);
+    unsigned long seen = lock->wakeups;
+    lock->idle++;
+    SaveState();
+    Release(lock, guard);
+    lock->changed.wait(guard, [&] {
+        return lock->wakeups != seen || lock->halting;
+    });
+    lock->idle--;
+    Acquire(lock, guard);
+    RestoreState();
+}
+
+void
+Multiprocessor::Stop()
+{
+    std::unique_lock<std::mutex> guard(lock->mutex);
+    lock->halting = true;
+    lock->changed.notify_all();
+    lock->changed.wait(guard, [&] {
+        return lock->idle + lock->waiting == count - 1;
+    });
+}
@@ -0,0 +1,135 @@
+/// Data structures to run user programs on several simulated processors.
+///
+/// Every processor has a `Machine` of its own, with its registers, TLB and
+/// cache of host addresses, and runs user code on a host thread of its own;
+/// physical memory and the decode cache are shared by all of them.  The
+/// kernel, which assumes a uniprocessor throughout, runs under a single
+/// lock: a processor takes it when it enters the kernel (on an exception,
+/// or when its tick budget runs out) and lets it go when it goes back to
+/// user code.  So user programs run in parallel, while the kernel runs on
+/// one processor at a time.
+///
+/// While a processor holds the lock, the globals `currentThread` and
+/// `machine`, and the interrupt level and status, are its own; they are
+/// saved when it lets the lock go and restored when it takes it again.
+///
+/// A thread that ran user code on a processor stays on it: its stack holds
+/// the simulation loop of that machine (see `Thread::processor`).  Every
+/// processor has an idle thread, which it runs when nothing else is ready;
+/// the last processor to go idle rolls simulated time forward, as
+/// `Interrupt::Idle` does on a uniprocessor.
+///
+/// Simulated time is shared: every processor advances it with the
+/// instructions it runs, which are counted when it enters the kernel.
+/// There is no timer: a thread yields its processor every
+/// `PROCESSOR_SLICE` ticks of its own.
+///
+/// The TLB of a processor cannot be flushed from another one, so several
+/// processors need a kernel that only changes the page tables of the
+/// address space it runs, that is, one without virtual memory.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_MULTIPROCESSOR__HH
+#define NACHOS_USERPROG_MULTIPROCESSOR__HH
+
+
+#include "machine/interrupt.hh"
+
+
+class Machine;
+class Thread;
+
+/// The kernel lock, and the processors waiting for it.
+class KernelLock;
+
+/// Most processors that can be simulated.
+const unsigned MAX_PROCESSORS = 16;
+
+/// User ticks that a thread runs before yielding its processor.
+const unsigned long PROCESSOR_SLICE = 1000;
+
+class Multiprocessor {
+public:
+
+    /// Initialize `count` processors, the first of which is the one running
+    /// now, with machine `boot`; the kernel lock is held by it.
+    Multiprocessor(unsigned count, Machine *boot);
+
+    /// Start the host threads of the other processors.
+    ///
+    /// Must be called from the main thread, once the kernel is
+    /// initialized.
+    void Start();
+
+    unsigned GetCount() const;
+
+    /// Return the index of the processor running the caller.
+    unsigned GetCurrent() const;
+
+    /// Whether the current processor may run `thread`.
+    bool MayRun(const Thread *thread) const;
+
+    /// Return the idle thread of the current processor, to run when no
+    /// other thread is ready.
+    Thread *GetIdleThread();
+
+    /// Take the kernel lock for the current processor, waiting for the
+    /// processors that asked for it before.
+    void Lock();
+
+    /// Let go of the kernel lock, to run user code for up to `budget`
+    /// ticks; returns the ticks that can actually run before the
+    /// processor must enter the kernel again.
+    unsigned long Unlock(unsigned long budget);
+
+    /// Let other processors waiting for the kernel lock take it, and take
+    /// it back.
+    void Preempt();
+
+    /// Tell idle processors that some thread became ready.
+    void Wake();
+
+    /// Called by the idle thread of the current processor, with the lock
+    /// held, when no thread is ready: wait until some thread becomes
+    /// ready, or roll simulated time forward if every other processor is
+    /// idle too.
+    void Idle();
+
+    /// Wait until every other processor is idle or waiting for the kernel
+    /// lock, and keep them so, before halting.
+    void Stop();
+
+private:
+
+    /// State of the kernel kept by a processor while another one holds
+    /// the lock.
+    struct Processor {
+        Machine *machine;
+        Thread *thread;  ///< Running on it.
+        Thread *idle;
+        IntStatus level;
+        MachineStatus status;
+    };
+
+    /// Make the kernel state of the current processor the running one,
+    /// once it takes the lock.
+    void RestoreState();
+
+    /// Keep the kernel state of the current processor, before it lets go
+    /// of the lock.
+    void SaveState();
+
+    /// Run by the host thread of processor `index`.
+    static void RunProcessor(Multiprocessor *self, unsigned index);
+
+    unsigned count;
+    Processor processors[MAX_PROCESSORS];
+
+    KernelLock *lock;
+};
+
+
+#endif
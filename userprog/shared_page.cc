@@ -0,0 +1,64 @@
+/// Routines to keep track of the address spaces mapping a shared page.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "shared_page.hh"
+
+
+SharedPage::SharedPage(unsigned frame_, unsigned vpn_)
+{
+    frame       = frame_;
+    vpn         = vpn_;
+    cached      = false;
+    mappings    = new List<AddressSpace *>;
+    numMappings = 0;
+}
+
+SharedPage::~SharedPage()
+{
+    delete mappings;
+}
+
+void
+SharedPage::Map(AddressSpace *space)
+{
+    ASSERT(space != nullptr);
+    ASSERT(!mappings->Has(space));
+
+    mappings->Append(space);
+    numMappings++;
+}
+
+void
+SharedPage::Unmap(AddressSpace *space)
+{
+    ASSERT(mappings->Has(space));
+
+    mappings->Remove(space);
+    numMappings--;
+}
+
+AddressSpace *
+SharedPage::GetMapping()
+{
+    return mappings->IsEmpty() ? nullptr : mappings->Head();
+}
+
+AddressSpace *
+SharedPage::PopMapping()
+{
+    if (mappings->IsEmpty()) {
+        return nullptr;
+    }
+    numMappings--;
+    return mappings->Pop();
+}
+
+unsigned
+SharedPage::CountMappings() const
+{
+    return numMappings;
+}
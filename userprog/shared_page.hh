@@ -0,0 +1,58 @@
+/// Data structures for pages mapped by several address spaces at once.
+///
+/// A frame of physical memory can hold a page that is the same in more than
+/// one address space, such as a page of code of a program that several of
+/// them run (see `text_cache.hh`), or a page of a process that neither it
+/// nor its copy made by `Fork` wrote since.  Every address space maps it at the
+/// same virtual page, read-only, so the first store to it raises a
+/// `READ_ONLY_EXCEPTION`; the address space then gets a private copy of the
+/// page (copy on write).
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_SHAREDPAGE__HH
+#define NACHOS_USERPROG_SHAREDPAGE__HH
+
+
+#include "lib/list.hh"
+
+
+class AddressSpace;
+
+class SharedPage {
+public:
+
+    /// Initialize a page held in frame `frame`, mapped at page `vpn` by no
+    /// address space yet.
+    SharedPage(unsigned frame, unsigned vpn);
+
+    ~SharedPage();
+
+    /// Record that `space` maps the page, or that it does not anymore.
+    void Map(AddressSpace *space);
+    void Unmap(AddressSpace *space);
+
+    /// Return some address space that maps the page, or null if none does.
+    AddressSpace *GetMapping();
+
+    /// Return an address space that maps the page, and forget it; or null
+    /// if none does.
+    AddressSpace *PopMapping();
+
+    unsigned CountMappings() const;
+
+    unsigned frame;  ///< Where the page is in physical memory.
+    unsigned vpn;    ///< Where the page is in every address space.
+    bool cached;     ///< Whether the page is kept in `textCache`.
+
+private:
+
+    /// Address spaces mapping the page.
+    List<AddressSpace *> *mappings;
+    unsigned numMappings;
+};
+
+
+#endif
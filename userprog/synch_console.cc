@@ -44,17 +44,14 @@ SynchConsole::~SynchConsole()
     delete lockWrite;
 }
 
-/// Read the contents of a disk sector into a buffer.  Return only after the
-/// data has been read.
-///
-/// * `sectorNumber` is the disk sector to read.
-/// * `data` is the buffer to hold the contents of the disk sector.
-void 
+/// Read up to `size` characters into `bufferDest`, stopping after a line
+/// ends.  Return how many were read.
+int
 SynchConsole::Read(char *bufferDest, int size)
 {
     ASSERT(bufferDest != nullptr);
     ASSERT(size > 0);
-    char ch;
+    char ch = 0;
     int count = 0;
     lockRead->Acquire();
     while(count < size && ch != 10) {
@@ -65,6 +62,7 @@ SynchConsole::Read(char *bufferDest, int size)
         count++;
     }
     lockRead->Release();
+    return count;
 }
 
 /// Write the contents of a buffer into a disk sector.  Return only
@@ -87,4 +85,19 @@ SynchConsole::Write(char *buffer, int size)
         count++;
     }
     lockWrite->Release();
-}
\ No newline at end of file
+}
+
+void
+SynchConsole::Write(const IoVec *from, unsigned count)
+{
+    ASSERT(from != nullptr);
+    lockWrite->Acquire();
+    for (unsigned i = 0; i < count; i++) {
+        for (unsigned j = 0; j < from[i].length; j++) {
+            console->PutChar(from[i].base[j]);
+            console->WriteDone();
+            writeDone->P();
+        }
+    }
+    lockWrite->Release();
+}
@@ -12,6 +12,7 @@
 #include "machine/disk.hh"
 #include "threads/lock.hh"
 #include "machine/console.hh"
+#include "lib/io_vec.hh"
 
 
 ///
@@ -33,9 +34,13 @@ public:
     /// 
     /// 
 
-    void Read(char *bufferDest, int size);
+    int Read(char *bufferDest, int size);
     void Write(char *buffer, int size);
 
+    /// Write the `count` pieces of `from` in order, with no other write in
+    /// between.
+    void Write(const IoVec *from, unsigned count);
+
 private:
     Console *console;
 };
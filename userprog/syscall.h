@@ -32,6 +32,14 @@
 #define SC_READ    14
 #define SC_WRITE   15
 #define SC_STATS   16
+#define SC_CHECKPOINT 17
+#define SC_READV   18
+#define SC_WRITEV  19
+#define SC_ENTER   20
+#define SC_ASYNC_READ  21
+#define SC_ASYNC_WRITE 22
+#define SC_WAIT    23
+#define SC_POLL    24
 
 
 #ifndef IN_ASM
@@ -49,7 +57,7 @@
 void Halt();
 
 
-/// Address space control operations: `Exit`, `Exec`, and `Join`.
+/// Address space control operations: `Exit`, `Exec`, `Fork`, and `Join`.
 
 /// This user program is done (`status = 0` means exited normally).
 void Exit(int status);
@@ -61,18 +69,23 @@ typedef int SpaceId;
 /// address space identifier.
 SpaceId Exec(char *name, int joinable, char** argv);
 
+/// Result of `Fork` in the new process.
+#define FORK_CHILD  (-2)
+
+/// Run a copy of this user program, with a copy of its memory, going on
+/// after the call, and return the address space identifier of the copy, as
+/// `Exec` does, or -1 on failure.  In the copy, return `FORK_CHILD`.
+///
+/// Open files, other than the console, are not inherited.
+SpaceId Fork(int joinable);
+
 /// Only return once the the user program `id` has finished.
 ///
 /// Return the exit status.
 int Join(SpaceId id);
 
 
-/// User-level thread operations: `Fork` and `Yield`.  To allow multiple
-/// threads to run within a user program.
-
-/// Fork a thread to run a procedure (`func`) in the *same* address space as
-/// the current thread.
-int Fork(void (*func)(void));
+/// User-level thread operations: `Yield`.
 
 /// Yield the CPU to another runnable thread, whether in this address space
 /// or not.
@@ -120,11 +133,110 @@ int Write(const char *buffer, int size, OpenFileId id);
 /// wait until you can retustarn at least one character).
 int Read(char *buffer, int size, OpenFileId id);
 
+/// One piece of the buffer of `ReadV` or `WriteV`: `size` bytes at `buffer`.
+typedef struct {
+    char *buffer;
+    int size;
+} IoPiece;
+
+/// Most pieces that `ReadV` and `WriteV` take.
+#define MAX_IO_PIECES  16
+
+/// Like `Read`, but filling the `count` pieces of `pieces` in turn, in a
+/// single call.
+int ReadV(const IoPiece *pieces, int count, OpenFileId id);
+
+/// Like `Write`, but writing the `count` pieces of `pieces` in turn, in a
+/// single call.
+int WriteV(const IoPiece *pieces, int count, OpenFileId id);
+
 /// Close the file, we are done reading and writing to it.
 int Close(OpenFileId id);
 
+/// Batched file system calls: `Enter`.
+///
+/// A program queues requests for `Create`, `Open`, `Read`, `Write` and
+/// `Close` in a ring of its own memory, and has many of them carried out
+/// with a single `Enter`, which posts their results back to the ring.
+///
+/// Requests are queued at `submissions[subTail % RING_SIZE]`, advancing
+/// `subTail`; the kernel takes them from `subHead`.  Results are posted at
+/// `completions[compTail % RING_SIZE]`, in the same order; the program
+/// takes them from `compHead`.  Every index only grows.
+
+#define RING_SIZE  32
+
+/// A request: system call `op` (such as `SC_READ`) with its arguments, as
+/// they would be passed to it.  `tag` comes back with its result.
+typedef struct {
+    int op;
+    int args[3];
+    int tag;
+} Submission;
+
+/// The `result` of the request submitted with `tag`.
+typedef struct {
+    int tag;
+    int result;
+} Completion;
+
+typedef struct {
+    unsigned subHead;   ///< Advanced by the kernel.
+    unsigned subTail;   ///< Advanced by the program.
+    unsigned compHead;  ///< Advanced by the program.
+    unsigned compTail;  ///< Advanced by the kernel.
+    Submission submissions[RING_SIZE];
+    Completion completions[RING_SIZE];
+} Ring;
+
+/// Carry out, in order, up to `count` of the requests queued in `ring`, as
+/// long as there is room for their results.
+///
+/// Return how many were carried out, or -1 if `ring` is not valid.
+int Enter(Ring *ring, int count);
+
+
+/// Asynchronous file operations: `AsyncRead`, `AsyncWrite`, `Wait`, `Poll`.
+///
+/// A transfer is submitted, and the program goes on running while the
+/// kernel carries it out; the result is collected later, once.  Transfers
+/// of the same file are carried out in the order they were submitted.
+
+/// Most bytes that one transfer moves; larger ones move only that many, or
+/// fewer if the kernel cannot keep all of their pages in memory at once.
+#define MAX_ASYNC_SIZE  4096
+
+/// Result of `Poll` for a transfer not over yet.
+#define ASYNC_PENDING  (-2)
+
+/// Start reading `size` bytes at `position` of the open file into
+/// `buffer`, which must not be used until the result is collected.
+///
+/// Return an identifier for the transfer, or -1 on failure.
+int AsyncRead(char *buffer, int size, int position, OpenFileId id);
+
+/// Start writing `size` bytes from `buffer` at `position` of the open file.
+/// The buffer must not be changed until the result is collected.
+///
+/// Return an identifier for the transfer, or -1 on failure.
+int AsyncWrite(const char *buffer, int size, int position, OpenFileId id);
+
+/// Wait until transfer `request` is over, and return the number of bytes
+/// moved, or -1 if there is no such transfer.
+int Wait(int request);
+
+/// Like `Wait`, but return `ASYNC_PENDING` at once, instead of waiting, if
+/// the transfer is not over yet.
+int Poll(int request);
+
 void Stats();
 
+/// Save the state of this program into a checkpoint, if Nachos was asked to
+/// (see `userprog/checkpoint.hh`).
+///
+/// Return 0 after saving it, 1 when resumed from it, and -1 on failure.
+int Checkpoint();
+
 
 #endif
 
@@ -0,0 +1,185 @@
+/// Routines to share the code of programs among address spaces.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "text_cache.hh"
+#include "executable.hh"
+#include "machine/mmu.hh"
+
+#include <string.h>
+
+
+class CachedProgram {
+public:
+    char *name;
+
+    /// Header of the executable, as far as it matters to its contents.
+    uint32_t codeAddr;
+    uint32_t codeSize;
+    uint32_t initDataAddr;
+    uint32_t initDataSize;
+
+    /// Cached page at every virtual page up to the end of the code.
+    SharedPage **pages;
+    unsigned numPages;
+
+    CachedProgram *next;
+};
+
+TextCache::TextCache(unsigned numFrames_)
+{
+    numFrames      = numFrames_;
+    programs       = nullptr;
+    pageInFrame    = new SharedPage * [numFrames];
+    programOfFrame = new CachedProgram * [numFrames];
+    for (unsigned i = 0; i < numFrames; i++) {
+        pageInFrame[i]    = nullptr;
+        programOfFrame[i] = nullptr;
+    }
+    idle = new List<SharedPage *>;
+}
+
+TextCache::~TextCache()
+{
+    for (unsigned i = 0; i < numFrames; i++) {
+        delete pageInFrame[i];
+    }
+    while (programs != nullptr) {
+        CachedProgram *program = programs;
+        programs = program->next;
+        delete [] program->name;
+        delete [] program->pages;
+        delete program;
+    }
+    delete [] pageInFrame;
+    delete [] programOfFrame;
+    delete idle;
+}
+
+CachedProgram *
+TextCache::FindProgram(const char *name, Executable *exe)
+{
+    ASSERT(name != nullptr);
+    ASSERT(exe != nullptr);
+
+    CachedProgram *program;
+    for (program = programs; program != nullptr; program = program->next) {
+        if (strcmp(program->name, name) == 0) {
+            break;
+        }
+    }
+    if (program != nullptr) {
+        if (program->codeAddr != exe->GetCodeAddr()
+              || program->codeSize != exe->GetCodeSize()
+              || program->initDataAddr != exe->GetInitDataAddr()
+              || program->initDataSize != exe->GetInitDataSize()) {
+            DEBUG('a', "Another program cached as %s\n", name);
+            return nullptr;
+        }
+        return program;
+    }
+
+    program = new CachedProgram;
+    program->name = new char [strlen(name) + 1];
+    strcpy(program->name, name);
+    program->codeAddr     = exe->GetCodeAddr();
+    program->codeSize     = exe->GetCodeSize();
+    program->initDataAddr = exe->GetInitDataAddr();
+    program->initDataSize = exe->GetInitDataSize();
+    program->numPages = program->codeSize == 0 ? 0
+                        : DivRoundUp(program->codeAddr + program->codeSize,
+                                     PAGE_SIZE);
+    program->pages = new SharedPage * [program->numPages];
+    for (unsigned i = 0; i < program->numPages; i++) {
+        program->pages[i] = nullptr;
+    }
+    program->next = programs;
+    programs = program;
+    DEBUG('a', "Caching the code of %s, %u pages\n", name, program->numPages);
+    return program;
+}
+
+SharedPage *
+TextCache::Find(CachedProgram *program, unsigned vpn) const
+{
+    ASSERT(program != nullptr);
+
+    return vpn < program->numPages ? program->pages[vpn] : nullptr;
+}
+
+void
+TextCache::Add(CachedProgram *program, SharedPage *page)
+{
+    ASSERT(program != nullptr);
+    ASSERT(page != nullptr && !page->cached);
+    ASSERT(page->vpn < program->numPages);
+    ASSERT(program->pages[page->vpn] == nullptr);
+    ASSERT(pageInFrame[page->frame] == nullptr);
+
+    program->pages[page->vpn]   = page;
+    pageInFrame[page->frame]    = page;
+    programOfFrame[page->frame] = program;
+    page->cached = true;
+    if (page->CountMappings() == 0) {
+        idle->Append(page);
+    }
+}
+
+void
+TextCache::Remove(SharedPage *page)
+{
+    ASSERT(page != nullptr && page->cached);
+    ASSERT(pageInFrame[page->frame] == page);
+
+    programOfFrame[page->frame]->pages[page->vpn] = nullptr;
+    pageInFrame[page->frame]    = nullptr;
+    programOfFrame[page->frame] = nullptr;
+    page->cached = false;
+    idle->Remove(page);
+}
+
+void
+TextCache::Release(SharedPage *page)
+{
+    ASSERT(page != nullptr && page->cached);
+    ASSERT(page->CountMappings() == 0);
+
+    idle->Append(page);
+}
+
+void
+TextCache::Reuse(SharedPage *page)
+{
+    ASSERT(page != nullptr && page->cached);
+
+    idle->Remove(page);
+}
+
+int
+TextCache::Reclaim()
+{
+    if (idle->IsEmpty()) {
+        return -1;
+    }
+    SharedPage *page = idle->Head();
+    unsigned frame = page->frame;
+    DEBUG('a', "Reclaiming frame %u, page %u of %s\n",
+          frame, page->vpn, programOfFrame[frame]->name);
+    Remove(page);
+    delete page;
+    return frame;
+}
+
+void
+TextCache::Drop(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+
+    SharedPage *page = pageInFrame[frame];
+    ASSERT(page != nullptr && page->CountMappings() == 0);
+    Remove(page);
+    delete page;
+}
@@ -0,0 +1,84 @@
+/// Data structures to share the code of programs among the address spaces
+/// running them.
+///
+/// The first address space running a program loads every page of its code
+/// segment into a frame, as usual, but leaves it in this cache; the others
+/// running the same program map that frame instead of loading their own
+/// copy (see `shared_page.hh`).
+///
+/// A program is known by the name of its executable file, together with its
+/// header, so that another program later found under the same name is not
+/// taken for it.  Pages stay cached while no address space maps them, so
+/// that a program run over and over is only loaded once; their frames are
+/// given back when memory runs short.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_TEXTCACHE__HH
+#define NACHOS_USERPROG_TEXTCACHE__HH
+
+
+#include "shared_page.hh"
+
+
+class Executable;
+
+/// The cached pages of one program.
+class CachedProgram;
+
+class TextCache {
+public:
+
+    /// Initialize an empty cache for pages in `numFrames` frames.
+    TextCache(unsigned numFrames);
+
+    /// Forget every program.  Frames are not freed.
+    ~TextCache();
+
+    /// Return the program in the executable file named `name`, opened as
+    /// `exe`, adding it if needed.
+    ///
+    /// Returns null if another program was cached under the same name.
+    CachedProgram *FindProgram(const char *name, Executable *exe);
+
+    /// Return the cached page `vpn` of `program`, or null if not cached.
+    SharedPage *Find(CachedProgram *program, unsigned vpn) const;
+
+    /// Keep `page` as page `vpn` of `program`.
+    void Add(CachedProgram *program, SharedPage *page);
+
+    /// Forget `page`, which must be cached.
+    void Remove(SharedPage *page);
+
+    /// Record that no address space maps `page` any longer, or that one
+    /// maps it again.  Until then, its frame can be given back.
+    void Release(SharedPage *page);
+    void Reuse(SharedPage *page);
+
+    /// Forget some page that no address space maps, and return its frame,
+    /// which is left in use; or -1 if there is no such page.
+    int Reclaim();
+
+    /// Forget the page in `frame`, which no address space may map.
+    void Drop(unsigned frame);
+
+private:
+
+    unsigned numFrames;
+
+    /// Programs cached, linked through their `next` field.
+    CachedProgram *programs;
+
+    /// Cached page in every frame, or null, and its program.
+    SharedPage **pageInFrame;
+    CachedProgram **programOfFrame;
+
+    /// Cached pages that no address space maps, in the order they were
+    /// released.
+    List<SharedPage *> *idle;
+};
+
+
+#endif
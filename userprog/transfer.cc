@@ -7,52 +7,90 @@
 #include "lib/utility.hh"
 #include "threads/system.hh"
 
+#include <string.h>
+
+
+/// Return where user address `userAddress` lives in `mainMemory`, and set
+/// `count` to how many of the `byteCount` bytes from there lie in the same
+/// page.
+///
+/// A failed translation raises its exception: the handler either makes the
+/// page available, so that the translation can be retried, or stops Nachos.
+/// The page stays available until the kernel blocks.
+static char *
+FindUserBytes(unsigned userAddress, unsigned byteCount, bool writing,
+              unsigned *count)
+{
+    ASSERT(count != nullptr);
+
+    MMU *mmu = machine->GetMMU();
+    char *host;
+    ExceptionType e;
+    while ((e = mmu->TranslateToHost(userAddress, writing, &host))
+             != NO_EXCEPTION) {
+        machine->RaiseException(e, userAddress);
+    }
+    *count = min(byteCount, PAGE_SIZE - userAddress % PAGE_SIZE);
+    return host;
+}
+
 void ReadBufferFromUser(int userAddress, char *outBuffer,
-                        unsigned byteCount) 
+                        unsigned byteCount)
 {
     ASSERT(userAddress != 0);
     ASSERT(outBuffer != nullptr);
     ASSERT(byteCount > 0);
 
-    unsigned count = 0;
-    while (count < byteCount) {
-        int temp;
-        ASSERT(machine->ReadMem(userAddress++, 1, &temp));
-        *(outBuffer + count++) = (unsigned char) temp;
+    while (byteCount > 0) {
+        unsigned count;
+        const char *from = FindUserBytes(userAddress, byteCount, false,
+                                         &count);
+        memcpy(outBuffer, from, count);
+        userAddress += count;
+        outBuffer   += count;
+        byteCount   -= count;
     }
 }
 
 bool ReadStringFromUser(int userAddress, char *outString,
-                        unsigned maxByteCount) 
+                        unsigned maxByteCount)
 {
     ASSERT(userAddress != 0);
     ASSERT(outString != nullptr);
     ASSERT(maxByteCount != 0);
 
-    unsigned count = 0;
-    do {
-        int temp;
-        count++;
-        ASSERT(machine->ReadMem(userAddress++, 1, &temp));
-        *outString = (unsigned char) temp;
-    } while (*outString++ != '\0' && count < maxByteCount);
-
-    return *(outString - 1) == '\0';
+    while (maxByteCount > 0) {
+        unsigned count;
+        const char *from = FindUserBytes(userAddress, maxByteCount, false,
+                                         &count);
+        const char *end = (const char *) memchr(from, '\0', count);
+        if (end != nullptr) {
+            memcpy(outString, from, end - from + 1);
+            return true;
+        }
+        memcpy(outString, from, count);
+        userAddress  += count;
+        outString    += count;
+        maxByteCount -= count;
+    }
+    return false;
 }
 
 void WriteBufferToUser(const char *buffer, int userAddress,
-                       unsigned byteCount) 
+                       unsigned byteCount)
 {
     ASSERT(userAddress != 0);
     ASSERT(buffer != nullptr);
 
-    if(byteCount != 0) {
-        unsigned count = 0;
-        do {
-            count++;
-            ASSERT(machine->WriteMem(userAddress++, 1, (int) *buffer));
-            buffer++;
-        } while (count < byteCount);
+    MMU *mmu = machine->GetMMU();
+    while (byteCount > 0) {
+        unsigned count;
+        char *to = FindUserBytes(userAddress, byteCount, true, &count);
+        memcpy(to, buffer, count);
+        mmu->InvalidateFrame((to - mmu->mainMemory) / PAGE_SIZE);
+        userAddress += count;
+        buffer      += count;
+        byteCount   -= count;
     }
 }
 
@@ -61,7 +99,94 @@ void WriteStringToUser(const char *string, int userAddress)
     ASSERT(userAddress != 0);
     ASSERT(string != nullptr);
 
-    do {
-        ASSERT(machine->WriteMem(userAddress++, 1, (int) *string));
-    } while (*string++ != '\0');
+    WriteBufferToUser(string, userAddress, strlen(string) + 1);
+}
+
+unsigned
+CountUserPages(int userAddress, unsigned byteCount)
+{
+    ASSERT(byteCount > 0);
+
+    unsigned first = userAddress / PAGE_SIZE;
+    unsigned last  = (userAddress + byteCount - 1) / PAGE_SIZE;
+    return min(last - first + 1, MAX_PINNED_PAGES);
+}
+
+unsigned
+ReservePins(unsigned numPages)
+{
+    ASSERT(numPages > 0 && numPages <= MAX_PINNED_PAGES);
+
+#ifdef VMEM
+    return coreMap->ReservePins(numPages, true);
+#else
+    // No frame is ever replaced.
+    return numPages;
+#endif
+}
+
+void
+ReleasePins(unsigned numPages)
+{
+#ifdef VMEM
+    coreMap->ReleasePins(numPages);
+#endif
+}
+
+unsigned
+PinUserBuffer(int userAddress, unsigned byteCount, bool writing,
+              IoVec *iov, unsigned *count, unsigned *numPages,
+              unsigned maxPages)
+{
+    ASSERT(userAddress != 0);
+    ASSERT(iov != nullptr);
+    ASSERT(count != nullptr);
+    ASSERT(numPages != nullptr);
+    ASSERT(maxPages <= MAX_PINNED_PAGES);
+
+    char *mainMemory = machine->GetMMU()->mainMemory;
+    unsigned numBytes = 0;
+    for (; *numPages < maxPages && byteCount > 0; (*numPages)++) {
+        unsigned size;
+        char *host = FindUserBytes(userAddress, byteCount, writing, &size);
+#ifdef VMEM
+        coreMap->Pin((host - mainMemory) / PAGE_SIZE);
+#endif
+        // Frames that happen to follow each other make a single piece, as
+        // long as no frame is left in it twice.
+        IoVec *last = *count > 0 ? &iov[*count - 1] : nullptr;
+        if (last != nullptr && last->base + last->length == host
+              && (host - mainMemory) % PAGE_SIZE == 0) {
+            last->length += size;
+        } else {
+            iov[*count].base   = host;
+            iov[*count].length = size;
+            (*count)++;
+        }
+        userAddress += size;
+        byteCount   -= size;
+        numBytes    += size;
+    }
+    return numBytes;
+}
+
+void
+UnpinUserBuffer(const IoVec *iov, unsigned count, bool written)
+{
+    ASSERT(iov != nullptr);
+
+    MMU *mmu = machine->GetMMU();
+    for (unsigned i = 0; i < count; i++) {
+        unsigned first = (iov[i].base - mmu->mainMemory) / PAGE_SIZE;
+        unsigned last  = (iov[i].base + iov[i].length - 1 - mmu->mainMemory)
+                         / PAGE_SIZE;
+        for (unsigned frame = first; frame <= last; frame++) {
+            if (written) {
+                mmu->InvalidateFrame(frame);
+            }
+#ifdef VMEM
+            coreMap->Unpin(frame);
+#endif
+        }
+    }
 }
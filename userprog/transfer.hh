@@ -7,6 +7,9 @@
 #define NACHOS_USERPROG_TRANSFER__HH
 
 
+#include "lib/io_vec.hh"
+
+
 /// Copy a byte array from virtual machine to host.
 void ReadBufferFromUser(int userAddress, char *outBuffer,
                         unsigned byteCount);
@@ -22,5 +25,40 @@ void WriteBufferToUser(const char *buffer, int userAddress,
 /// Copy a C string from host to virtual machine.
 void WriteStringToUser(const char *string, int userAddress);
 
+/// Most pages of a user buffer that a transfer keeps in memory at once.
+const unsigned MAX_PINNED_PAGES = 16;
+
+/// Number of pages of user memory that the `byteCount` bytes at
+/// `userAddress` fall in, but at most `MAX_PINNED_PAGES`.
+unsigned CountUserPages(int userAddress, unsigned byteCount);
+
+/// Reserve room to pin `numPages` frames for a transfer, or as many as are
+/// left to pin: transfers share a budget (see `CoreMap::ReservePins`).
+/// Waits until there is room for at least one, so the caller must not hold
+/// any that only it would give back.  Returns the number of frames that may
+/// be pinned.
+unsigned ReservePins(unsigned numPages);
+
+/// Give back the room reserved for `numPages` frames, once unpinned.
+void ReleasePins(unsigned numPages);
+
+/// Describe the start of the `byteCount` bytes of user memory at
+/// `userAddress` by the pieces of `mainMemory` holding them, and keep their
+/// frames from being replaced, so that the kernel can transfer data
+/// straight into (if `writing`) or out of them, even if it blocks.
+///
+/// The pieces are added to the `count` already in `iov`, which has room for
+/// `MAX_PINNED_PAGES`, as long as fewer than `maxPages` pages, reserved
+/// with `ReservePins`, are pinned; `numPages` counts them.  Returns the
+/// number of bytes described.
+unsigned PinUserBuffer(int userAddress, unsigned byteCount, bool writing,
+                       IoVec *iov, unsigned *count, unsigned *numPages,
+                       unsigned maxPages);
+
+/// Let the frames of the `count` pieces of `iov`, described by
+/// `PinUserBuffer`, be replaced again, telling the MMU if they were
+/// `written`.
+void UnpinUserBuffer(const IoVec *iov, unsigned count, bool written);
+
 
 #endif
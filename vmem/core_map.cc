@@ -0,0 +1,290 @@
+/// Routines to keep track of the frames of physical memory.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "core_map.hh"
+#include "threads/condition.hh"
+#include "threads/lock.hh"
+#include "userprog/address_space.hh"
+
+#include <string.h>
+
+
+bool
+ParseReplacementPolicy(const char *name, ReplacementPolicy *policy)
+{
+    ASSERT(name != nullptr);
+    ASSERT(policy != nullptr);
+
+    static const struct {
+        const char *name;
+        ReplacementPolicy policy;
+    } policies[] = {
+        { "fifo",     REPLACE_FIFO     },
+        { "clock",    REPLACE_CLOCK    },
+        { "enhanced", REPLACE_ENHANCED },
+        { "lru",      REPLACE_LRU      }
+    };
+    for (unsigned i = 0; i < sizeof policies / sizeof *policies; i++) {
+        if (strcmp(name, policies[i].name) == 0) {
+            *policy = policies[i].policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+CoreMap::CoreMap(FrameTable *frames_, ReplacementPolicy policy_)
+{
+    ASSERT(frames_ != nullptr);
+
+    frames    = frames_;
+    numFrames = frames->GetNumFrames();
+    policy    = policy_;
+    pinned = new unsigned [numFrames];
+    ages   = new unsigned [numFrames];
+    for (unsigned i = 0; i < numFrames; i++) {
+        pinned[i] = 0;
+        ages[i]   = 0;
+    }
+    hand = 0;
+
+    pinRoom      = max(1U, numFrames / 4);
+    pinLock      = new Lock("pin room");
+    pinsReleased = new Condition("pins released", pinLock);
+    unpinned     = new Condition("unpinned", pinLock);
+}
+
+CoreMap::~CoreMap()
+{
+    delete [] pinned;
+    delete [] ages;
+    delete pinsReleased;
+    delete unpinned;
+    delete pinLock;
+}
+
+int
+CoreMap::Find(AddressSpace *space, unsigned vpn)
+{
+    ASSERT(space != nullptr);
+
+    int frame = frames->Take(space, vpn);
+    if (frame != -1) {
+        ages[frame] = 0;
+    }
+    return frame;
+}
+
+void
+CoreMap::Reassign(unsigned frame, AddressSpace *space, unsigned vpn)
+{
+    ASSERT(frame < numFrames);
+    ASSERT(space != nullptr);
+
+    frames->Reassign(frame, space, vpn);
+    ages[frame] = 0;
+}
+
+void
+CoreMap::Clear(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+    ASSERT(pinned[frame] == 0);
+
+    frames->Free(frame);
+}
+
+unsigned
+CoreMap::PickVictim()
+{
+    ASSERT(frames->GetOldest() != -1);
+
+    // The threads holding the pins are loading pages or transferring data,
+    // and unpin the frames when done.  The victim is pinned before the lock
+    // is let go, which may switch threads, so that no other thread picks it.
+    pinLock->Acquire();
+    while (!HasCandidate()) {
+        DEBUG('a', "Every frame is pinned, waiting for one\n");
+        unpinned->Wait();
+    }
+
+    unsigned victim;
+    switch (policy) {
+        case REPLACE_CLOCK:
+            victim = PickClock();
+            break;
+        case REPLACE_ENHANCED:
+            victim = PickEnhanced();
+            break;
+        case REPLACE_LRU:
+            victim = PickLRU();
+            break;
+        default:
+            victim = PickFIFO();
+            break;
+    }
+    Pin(victim);
+    pinLock->Release();
+    return victim;
+}
+
+unsigned
+CoreMap::PickFIFO()
+{
+    // Pinned frames go to the back, as if they had just been taken; there
+    // must be some frame that is not pinned.
+    for (unsigned tries = 0; ; tries++) {
+        ASSERT(tries < numFrames);
+        unsigned frame = frames->GetOldest();
+        frames->Renew(frame);
+        if (!pinned[frame]) {
+            return frame;
+        }
+    }
+}
+
+unsigned
+CoreMap::PickClock()
+{
+    // Every frame passed by loses its `use` bit, so the hand stops within
+    // two turns.
+    for (unsigned tries = 0; ; tries++) {
+        ASSERT(tries < 2 * numFrames);
+        unsigned frame = hand;
+        hand = (hand + 1) % numFrames;
+        if (!IsCandidate(frame)) {
+            continue;
+        }
+        TranslationEntry *entry = GetEntry(frame);
+        if (entry == nullptr || !entry->use) {
+            return frame;
+        }
+        entry->use = false;
+    }
+}
+
+unsigned
+CoreMap::PickEnhanced()
+{
+    // Look for a frame neither used nor modified; failing that, for one
+    // modified but not used, clearing `use` bits on the way.  Within four
+    // turns, some frame must be found.
+    for (unsigned turn = 0; turn < 4; turn++) {
+        bool clearUse = turn % 2 == 1;
+        for (unsigned i = 0; i < numFrames; i++) {
+            unsigned frame = hand;
+            hand = (hand + 1) % numFrames;
+            if (!IsCandidate(frame)) {
+                continue;
+            }
+            TranslationEntry *entry = GetEntry(frame);
+            if (entry == nullptr
+                  || (!entry->use && (clearUse || !entry->dirty))) {
+                return frame;
+            }
+            if (clearUse) {
+                entry->use = false;
+            }
+        }
+    }
+    ASSERT(false);
+    return 0;
+}
+
+unsigned
+CoreMap::PickLRU()
+{
+    const unsigned USED = 1U << 31;
+
+    // Pinned frames are skipped: their pages may not be loaded yet.
+    int victim = -1;
+    for (unsigned frame = 0; frame < numFrames; frame++) {
+        if (!IsCandidate(frame)) {
+            continue;
+        }
+        TranslationEntry *entry = GetEntry(frame);
+        ages[frame] = ages[frame] >> 1
+                      | (entry != nullptr && entry->use ? USED : 0);
+        if (entry != nullptr) {
+            entry->use = false;
+        }
+        if (victim == -1 || ages[frame] < ages[victim]) {
+            victim = frame;
+        }
+    }
+    ASSERT(victim != -1);
+    return victim;
+}
+
+bool
+CoreMap::IsCandidate(unsigned frame) const
+{
+    return frames->IsInUse(frame) && pinned[frame] == 0;
+}
+
+bool
+CoreMap::HasCandidate() const
+{
+    for (unsigned frame = 0; frame < numFrames; frame++) {
+        if (IsCandidate(frame)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TranslationEntry *
+CoreMap::GetEntry(unsigned frame)
+{
+    AddressSpace *owner = frames->GetOwner(frame);
+    return owner != nullptr ? owner->GetPageEntry(frames->GetPage(frame))
+                            : nullptr;
+}
+
+void
+CoreMap::Pin(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+    pinned[frame]++;
+}
+
+void
+CoreMap::Unpin(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+    ASSERT(pinned[frame] > 0);
+
+    if (--pinned[frame] == 0) {
+        pinLock->Acquire();
+        unpinned->Broadcast();
+        pinLock->Release();
+    }
+}
+
+unsigned
+CoreMap::ReservePins(unsigned count, bool wait)
+{
+    pinLock->Acquire();
+    while (wait && count > 0 && pinRoom == 0) {
+        pinsReleased->Wait();
+    }
+    unsigned reserved = min(count, pinRoom);
+    pinRoom -= reserved;
+    pinLock->Release();
+    return reserved;
+}
+
+void
+CoreMap::ReleasePins(unsigned count)
+{
+    pinLock->Acquire();
+    pinRoom += count;
+    if (count > 0) {
+        pinsReleased->Broadcast();
+    }
+    pinLock->Release();
+}
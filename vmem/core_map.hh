@@ -0,0 +1,134 @@
+/// Data structures to keep track of the frames of physical memory, when
+/// pages are loaded on demand.
+///
+/// Every frame in use belongs to one page of one address space or, if the
+/// page is shared, to one of the address spaces mapping it; a page of code
+/// that no address space maps any longer belongs to the text cache (see
+/// `userprog/text_cache.hh`).  Frames are allocated, and their owners
+/// recorded, by a frame table (see `userprog/frame_table.hh`).  When no
+/// frame is free, one of them is chosen as a victim, following the
+/// replacement policy given with `-rp`, and its page is written out to the
+/// swap file of its address space.
+///
+/// Frames pinned for transfers, or to load clusters of pages at once, come
+/// out of a single budget, a quarter of them.  Frames of single pages being
+/// loaded or copied are pinned besides, one or two for every thread, so with
+/// enough threads every frame may be pinned at once; the next victim then
+/// waits until one is unpinned.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_COREMAP__HH
+#define NACHOS_VMEM_COREMAP__HH
+
+
+#include "machine/translation_entry.hh"
+#include "userprog/frame_table.hh"
+
+
+class AddressSpace;
+class Condition;
+class Lock;
+
+/// Ways of choosing the frame to free.  Except for FIFO, they look at the
+/// `use` and `dirty` bits that the MMU sets in the page table entries.
+enum ReplacementPolicy {
+    REPLACE_FIFO,      ///< The frame taken longest ago.
+    REPLACE_CLOCK,     ///< The next frame, in turn, not used since last
+                       ///< passing by it (second chance).
+    REPLACE_ENHANCED,  ///< Like `REPLACE_CLOCK`, but preferring frames
+                       ///< not modified (enhanced second chance).
+    REPLACE_LRU        ///< The frame unused for longest, approximated by
+                       ///< aging the `use` bits at every replacement.
+};
+
+/// Set `policy` from its name: `fifo`, `clock`, `enhanced` or `lru`.
+///
+/// Returns false if the name is not known.
+bool ParseReplacementPolicy(const char *name, ReplacementPolicy *policy);
+
+class CoreMap {
+public:
+
+    /// Initialize a map of the frames allocated from `frames`, every one
+    /// free, replaced following `policy`.
+    CoreMap(FrameTable *frames, ReplacementPolicy policy);
+
+    ~CoreMap();
+
+    /// Take a free frame for page `vpn` of `space`.
+    ///
+    /// Returns -1 if no frame is free.
+    int Find(AddressSpace *space, unsigned vpn);
+
+    /// Give frame `frame`, which must be in use, to page `vpn` of `space`.
+    void Reassign(unsigned frame, AddressSpace *space, unsigned vpn);
+
+    /// Free frame `frame`, which must not be pinned.
+    void Clear(unsigned frame);
+
+    /// Choose a frame in use to be freed, among those not pinned, and pin
+    /// it; wait until some frame is unpinned if every one is pinned.
+    unsigned PickVictim();
+
+    /// Keep frame `frame` from being chosen as a victim, while the kernel
+    /// transfers its contents; it stays pinned until unpinned as many
+    /// times.
+    void Pin(unsigned frame);
+    void Unpin(unsigned frame);
+
+    /// Reserve room to pin up to `count` frames, out of a quarter of them
+    /// shared by every transfer and every cluster of pages loading.  The
+    /// frame of a single page being loaded or copied needs no room.
+    ///
+    /// If `wait`, waits until some room is left; the caller must hold none
+    /// that only it would give back, or it could wait forever.  Returns the
+    /// number of frames reserved, which is then at least one.
+    unsigned ReservePins(unsigned count, bool wait);
+
+    /// Give back the room reserved for `count` frames, once unpinned.
+    void ReleasePins(unsigned count);
+
+private:
+
+    unsigned PickFIFO();
+    unsigned PickClock();
+    unsigned PickEnhanced();
+    unsigned PickLRU();
+
+    /// Whether frame `frame` is in use and not pinned.
+    bool IsCandidate(unsigned frame) const;
+
+    /// Whether some frame is a candidate.
+    bool HasCandidate() const;
+
+    /// Return the page table entry of the page in `frame`, or null if the
+    /// text cache owns it (no address space uses it).
+    TranslationEntry *GetEntry(unsigned frame);
+
+    FrameTable *frames;
+    unsigned numFrames;
+
+    ReplacementPolicy policy;
+
+    unsigned *pinned;
+
+    /// Room left to pin frames, and the lock and conditions to wait for
+    /// some of it to be given back, or for some frame to be unpinned.
+    unsigned pinRoom;
+    Lock *pinLock;
+    Condition *pinsReleased;
+    Condition *unpinned;
+
+    /// Next frame to look at, for the clock policies.
+    unsigned hand;
+
+    /// History of the `use` bit of every frame, most recent in the highest
+    /// bit, for `REPLACE_LRU`.
+    unsigned *ages;
+};
+
+
+#endif
@@ -0,0 +1,89 @@
+#!/bin/sh
+# Comparison of the page replacement policies.
+#
+# Runs every program of the corpus under every policy, with the *VMEM*
+# kernel, and prints one tab-separated line per run, after a header line:
+#
+#     program policy status faults writes disk_ticks
+#
+# `faults` are pages read in, and `writes` pages written back to swap;
+# together, they are the disk traffic due to paging.  `disk_ticks` is the
+# simulated time spent on it, which is only counted when swap files are on
+# the simulated disk (the `filesys` kernel); with the stub file system it is
+# 0.  `status` is `ok` if the machine halted, `timeout`, `missing` if the
+# kernel or the program is not built, or `failed` otherwise; the other
+# fields are then empty.  A program the kernel cannot load (with `filesys`,
+# one whose swap file would be bigger than `MAX_FILE_SIZE`) is `failed`,
+# but the kernel then waits for the console, so only at the time limit.
+#
+# Usage: `replacement.sh [program...]`, from anywhere; by default, the
+# programs are `page_bench`, `matmult` and `sort`.  The kernel and the
+# programs in `userland` must already be built (`make` at the top).  Set
+# `CONFIG` to use the kernel of another directory, and `BENCH_TIMEOUT` to
+# change the time limit of every run, in seconds.
+#
+# Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+# All rights reserved.  See `copyright.h` for copyright notice and
+# limitation of liability and disclaimer of warranty provisions.
+
+BASE_DIR=$(cd "$(dirname "$0")/.." && pwd)
+PROGRAMS=${*:-"page_bench matmult sort"}
+POLICIES="fifo clock enhanced lru"
+CONFIG=${CONFIG:-vmem}
+TIMEOUT=${BENCH_TIMEOUT:-300}
+
+# The console polls standard input, and gives up at end of file; a FIFO
+# opened for reading and writing never reaches it.
+INPUT=$(mktemp -u)
+mkfifo "$INPUT" || exit 1
+trap 'rm -f "$INPUT"' EXIT
+
+printf 'program\tpolicy\tstatus\tfaults\twrites\tdisk_ticks\n'
+
+for program in $PROGRAMS; do
+    for policy in $POLICIES; do
+        nachos=$BASE_DIR/$CONFIG/nachos
+        executable=$BASE_DIR/userland/$program
+        if [ ! -x "$nachos" ] || [ ! -f "$executable" ]; then
+            printf '%s\t%s\tmissing\t\t\t\n' "$program" "$policy"
+            continue
+        fi
+
+        # With a real file system, the program has to be copied into it.
+        case $CONFIG in
+            filesys|network) args="-f -cp $executable $program -x $program" ;;
+            *)               args="-x $executable" ;;
+        esac
+
+        output=$({ cd "$BASE_DIR/$CONFIG" &&
+                   timeout "$TIMEOUT" stdbuf -oL \
+                       ./nachos -rp $policy $args 0<>"$INPUT"; } 2>&1)
+        result=$?
+
+        if printf '%s\n' "$output" | grep -a -q 'Unable to load file'; then
+            status=failed
+        elif [ $result -eq 124 ]; then
+            status=timeout
+        elif [ $result -ne 0 ] ||
+             ! printf '%s\n' "$output" | grep -a -q 'Machine halting!'; then
+            status=failed
+        else
+            status=ok
+        fi
+        if [ $status != ok ]; then
+            printf '%s\t%s\t%s\t\t\t\n' "$program" "$policy" "$status"
+            continue
+        fi
+
+        printf '%s\n' "$output" | awk -v program="$program" \
+                                      -v policy="$policy" '
+            index($0, "Paging:") == 1 {
+                gsub(",", "")
+                for (i = 2; i < NF; i++) {
+                    value[$i] = $(i + 1)
+                }
+                printf "%s\t%s\tok\t%d\t%d\t%d\n", program, policy,
+                       value["faults"], value["writes"], value["ticks"]
+            }'
+    done
+done